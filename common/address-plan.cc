@@ -0,0 +1,145 @@
+#include "address-plan.h"
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/ipv4.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AddressPlan");
+
+const uint32_t AddressPlan::NO_NODE;
+
+AddressPlan::AddressPlan (Ipv4Address network, Ipv4Mask mask)
+  : m_next (network.Get () & mask.Get ()),
+    m_shift (22),
+    m_count (0)
+{
+  m_end = m_next + (uint64_t (~mask.Get ()) + 1);
+  m_keys.resize (1024, 0);
+  m_values.resize (1024, NO_NODE);
+}
+
+Ipv4InterfaceContainer
+AddressPlan::AssignPointToPoint (const NetDeviceContainer &devices)
+{
+  NS_ABORT_MSG_IF (devices.GetN () != 2, "A point-to-point link needs exactly two devices");
+  return Assign (devices, 4);
+}
+
+Ipv4InterfaceContainer
+AddressPlan::AssignSubnet (const NetDeviceContainer &devices, uint32_t prefixLength)
+{
+  NS_ABORT_MSG_IF (prefixLength > 30, "Prefix /" << prefixLength << " is too small for a subnet");
+  uint64_t blockSize = uint64_t (1) << (32 - prefixLength);
+  // network and broadcast address on top of the hosts
+  while (blockSize < uint64_t (devices.GetN ()) + 2)
+    {
+      blockSize <<= 1;
+    }
+  return Assign (devices, blockSize);
+}
+
+Ipv4InterfaceContainer
+AddressPlan::Assign (const NetDeviceContainer &devices, uint64_t blockSize)
+{
+  uint64_t network = (m_next + blockSize - 1) & ~uint64_t (blockSize - 1);
+  NS_ABORT_MSG_IF (network + blockSize > m_end, "Address pool exhausted after " << m_count << " addresses");
+  m_next = network + blockSize;
+
+  Ipv4Mask mask (~uint32_t (blockSize - 1));
+  Ipv4InterfaceContainer interfaces;
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<NetDevice> device = devices.Get (i);
+      Ptr<Node> node = device->GetNode ();
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ABORT_MSG_IF (ipv4 == 0, "Node " << node->GetId () << " has no IPv4 stack");
+
+      int32_t interface = ipv4->GetInterfaceForDevice (device);
+      if (interface == -1)
+        {
+          interface = ipv4->AddInterface (device);
+        }
+      Ipv4Address address (uint32_t (network + 1 + i));
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, mask));
+      ipv4->SetMetric (interface, 1);
+      ipv4->SetUp (interface);
+      interfaces.Add (ipv4, interface);
+      Insert (address.Get (), node->GetId ());
+    }
+  NS_LOG_LOGIC ("Assigned " << Ipv4Address (uint32_t (network)) << mask << " to " << devices.GetN () << " devices");
+  return interfaces;
+}
+
+void
+AddressPlan::Insert (uint32_t address, uint32_t nodeId)
+{
+  if (2 * (m_count + 1) > m_keys.size ())
+    {
+      std::vector<uint32_t> keys (2 * m_keys.size (), 0);
+      std::vector<uint32_t> values (2 * m_keys.size (), NO_NODE);
+      m_keys.swap (keys);
+      m_values.swap (values);
+      m_shift--;
+      m_count = 0;
+      for (uint32_t i = 0; i < keys.size (); i++)
+        {
+          if (keys[i] != 0)
+            {
+              Insert (keys[i], values[i]);
+            }
+        }
+    }
+
+  uint32_t slotMask = m_keys.size () - 1;
+  uint32_t slot = Slot (address);
+  while (m_keys[slot] != 0 && m_keys[slot] != address)
+    {
+      slot = (slot + 1) & slotMask;
+    }
+  if (m_keys[slot] == 0)
+    {
+      m_count++;
+    }
+  m_keys[slot] = address;
+  m_values[slot] = nodeId;
+}
+
+uint32_t
+AddressPlan::LookupNode (Ipv4Address address) const
+{
+  uint32_t key = address.Get ();
+  if (key == 0)
+    {
+      return NO_NODE;
+    }
+  uint32_t slotMask = m_keys.size () - 1;
+  uint32_t slot = Slot (key);
+  while (m_keys[slot] != 0)
+    {
+      if (m_keys[slot] == key)
+        {
+          return m_values[slot];
+        }
+      slot = (slot + 1) & slotMask;
+    }
+  return NO_NODE;
+}
+
+uint32_t
+AddressPlan::Slot (uint32_t address) const
+{
+  // Fibonacci hashing: the top bits of the product mix every address bit
+  return (address * 2654435761u) >> m_shift;
+}
+
+uint32_t
+AddressPlan::GetNAddresses (void) const
+{
+  return m_count;
+}
+
+} // namespace ns3
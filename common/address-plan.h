@@ -0,0 +1,73 @@
+#ifndef ADDRESS_PLAN_H
+#define ADDRESS_PLAN_H
+
+#include <vector>
+
+#include "ns3/ipv4-address.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+
+namespace ns3 {
+
+/**
+ * Hands out IPv4 subnets from one pool and remembers which node owns
+ * every assigned address.
+ *
+ * Point-to-point links get a /30 each; shared media such as a wifi
+ * channel get a block of at least /16, larger if the devices do not fit.
+ * Blocks are aligned to their size and taken in increasing address order,
+ * so a pool of 10.0.0.0/8 holds about four million links.  Addresses are
+ * set on the interfaces directly, without the global Ipv4AddressGenerator,
+ * whose collision check is linear in the number of allocated ranges, so
+ * assigning n interfaces is O(n).  Use a single plan per simulation and do
+ * not mix it with an Ipv4AddressHelper on the same pool.
+ *
+ * The reverse index is an open addressing hash table from address to node
+ * id, giving O(1) lookups without a per-entry allocation.
+ */
+class AddressPlan
+{
+public:
+  static const uint32_t NO_NODE = 0xffffffff;
+
+  /**
+   * \param network first address of the pool
+   * \param mask mask of the pool
+   */
+  AddressPlan (Ipv4Address network = Ipv4Address ("10.0.0.0"), Ipv4Mask mask = Ipv4Mask ("255.0.0.0"));
+
+  /**
+   * Put the two devices of a point-to-point link in a new /30; the first
+   * device gets the first host address.
+   */
+  Ipv4InterfaceContainer AssignPointToPoint (const NetDeviceContainer &devices);
+
+  /**
+   * Put the devices in a new block of at least /prefixLength that also
+   * holds all of them, in order from the first host address.
+   */
+  Ipv4InterfaceContainer AssignSubnet (const NetDeviceContainer &devices, uint32_t prefixLength = 16);
+
+  /**
+   * \return the id of the node that owns address, or NO_NODE
+   */
+  uint32_t LookupNode (Ipv4Address address) const;
+
+  uint32_t GetNAddresses (void) const;
+
+private:
+  Ipv4InterfaceContainer Assign (const NetDeviceContainer &devices, uint64_t blockSize);
+  void Insert (uint32_t address, uint32_t nodeId);
+  uint32_t Slot (uint32_t address) const;
+
+  uint64_t m_next;   //!< first free address of the pool
+  uint64_t m_end;    //!< one past the last address of the pool
+  std::vector<uint32_t> m_keys;    //!< address per slot, 0 for a free slot
+  std::vector<uint32_t> m_values;  //!< node id per slot
+  uint32_t m_shift;  //!< 32 - log2 (number of slots)
+  uint32_t m_count;
+};
+
+} // namespace ns3
+
+#endif /* ADDRESS_PLAN_H */
@@ -0,0 +1,20 @@
+# ns-3 build settings shared by the Makefiles of this tree.  Set
+# NS3_MODULES before including it.
+#
+# NS3_BUILD is the build directory of a configured and built ns-3 tree,
+# which holds ns3/*.h and the libns3 libraries; NS3_VERSION and
+# NS3_PROFILE pick the library names,
+# libns$(NS3_VERSION)-<module>-$(NS3_PROFILE).so.
+
+NS3_BUILD ?= ../../ns-3.24/build
+NS3_VERSION ?= 3.24
+NS3_PROFILE ?= debug
+
+CXX ?= g++
+CXXFLAGS ?= -O2 -g -Wall
+CPPFLAGS += -I$(NS3_BUILD)
+ifeq ($(NS3_PROFILE),debug)
+CPPFLAGS += -DNS3_ASSERT_ENABLE -DNS3_LOG_ENABLE
+endif
+LDFLAGS += -L$(NS3_BUILD) -Wl,-rpath,$(abspath $(NS3_BUILD))
+LDLIBS += $(foreach m,$(NS3_MODULES),-lns$(NS3_VERSION)-$(m)-$(NS3_PROFILE))
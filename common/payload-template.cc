@@ -0,0 +1,56 @@
+#include "payload-template.h"
+
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PayloadTemplate");
+
+uint64_t PayloadTemplate::s_built = 0;
+uint64_t PayloadTemplate::s_copies = 0;
+
+PayloadTemplate::PayloadTemplate ()
+{
+}
+
+Ptr<Packet>
+PayloadTemplate::Get (uint32_t size)
+{
+  if (m_template == 0 || m_template->GetSize () != size)
+    {
+      NS_LOG_LOGIC ("Building a " << size << " byte template");
+      m_template = Create<Packet> (size);
+      s_built++;
+    }
+  s_copies++;
+  return m_template->Copy ();
+}
+
+uint64_t
+PayloadTemplate::GetNBuilt (void)
+{
+  return s_built;
+}
+
+uint64_t
+PayloadTemplate::GetNCopies (void)
+{
+  return s_copies;
+}
+
+void
+PayloadTemplate::Print (std::ostream &os)
+{
+  Print (os, s_built, s_copies);
+}
+
+void
+PayloadTemplate::Print (std::ostream &os, uint64_t built, uint64_t copies)
+{
+  os << "Payload templates " << built
+     << " copies " << copies
+     // each template replaces one of the constructions it saves
+     << " constructions avoided " << (copies > built ? copies - built : 0) << std::endl;
+}
+
+} // namespace ns3
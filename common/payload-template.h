@@ -0,0 +1,67 @@
+#ifndef PAYLOAD_TEMPLATE_H
+#define PAYLOAD_TEMPLATE_H
+
+#include <iostream>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+/**
+ * One immutable payload packet that a sender hands out copies of, for
+ * traffic whose content nobody reads (worm trains, bulk or on/off data).
+ *
+ * Get () returns a Copy () of the template, which shares its buffer
+ * copy-on-write instead of constructing a new packet, buffer and metadata
+ * and drawing a new uid: every copy is one packet construction avoided.
+ * All copies carry the template's uid, so tools that follow packets by uid
+ * (NetAnim metadata) see one packet.  The buffer is shared until someone
+ * writes to it: the first header added in front takes the free room, and
+ * later copies get a private buffer when they add theirs, so the saving
+ * is in construction, not in every buffer allocation.
+ *
+ * The counters are per run, over every template.
+ */
+class PayloadTemplate
+{
+public:
+  PayloadTemplate ();
+
+  /**
+   * \return a copy of the template of size bytes; the template is built
+   * on first use and again when the size changes
+   */
+  Ptr<Packet> Get (uint32_t size);
+
+  /**
+   * \return the number of templates built
+   */
+  static uint64_t GetNBuilt (void);
+
+  /**
+   * \return the number of copies handed out, i.e. packet constructions
+   * avoided
+   */
+  static uint64_t GetNCopies (void);
+
+  /**
+   * One line: "Payload templates T copies C constructions avoided A".
+   */
+  static void Print (std::ostream &os);
+
+  /**
+   * The same line for counters summed elsewhere, e.g. over MPI ranks.
+   */
+  static void Print (std::ostream &os, uint64_t built, uint64_t copies);
+
+private:
+  Ptr<Packet> m_template;
+
+  static uint64_t s_built;
+  static uint64_t s_copies;
+};
+
+} // namespace ns3
+
+#endif /* PAYLOAD_TEMPLATE_H */
@@ -0,0 +1,365 @@
+// Run independent replications of a scenario until every output metric's
+// 95% confidence interval is tight enough, instead of a fixed count.
+//
+// Usage: replicate [-r relative] [-a absolute] [-n min] [-N max] [-j jobs] [-s first]
+//                  [-A arg ... -B arg ...] -m name=regex [-m ...] -- binary [args ...]
+//
+// Replication k runs "binary args --RngRun=k", starting at -s (default 1),
+// so every replication draws from its own substream of the same seed.  Each
+// -m extracts a metric from the replication's stdout: the first
+// parenthesised group of the POSIX extended regex, on every line it
+// matches.  A regex that matches several lines (one per flow, say) yields
+// name[0], name[1], ...  Means and variances are kept online (Welford).
+//
+// After at least -n replications (default 5) the run stops once the
+// half-width of every metric's 95% Student-t interval is at most -r
+// (default 0.05) times the absolute mean or -a (default 0), whichever is
+// larger, or after -N replications (default 1000).  With -j, replications
+// run in batches of that size and the rule is checked after each batch.
+// Without -a, metrics whose mean is 0 need a zero-width interval.
+//
+// Paired mode (-A / -B, each repeatable): every replication runs both arms,
+// the binary with the -A arguments and with the -B arguments, under the
+// same --RngRun, so with common random numbers (p3 --crn=true) they see the
+// same placement and traffic.  The stopping rule then applies to the
+// per-replication difference A - B, with the tolerance scaled by the
+// larger of the arms' absolute means instead of the difference's, so that
+// equal arms converge too.  Only precision stops a run: stopping as soon as
+// the interval excludes 0 would test after every batch and report an
+// interval narrower than its 95%.  The report gives both arms' means,
+// the difference with its interval and the variance reduction
+// (Var A + Var B) / Var (A - B): how many times fewer replications the
+// pairing needs than two independent arms for the same interval.
+//
+// Examples:
+//   replicate -m 'goodput=goodput ([0-9.e+-]+)' -- build/scratch/p1 --nFlows=2
+//   replicate -m 'gp=Goodput: ([0-9.e+-]+)' -- build/scratch/p2 --queueType=RED
+//   replicate -m 'infected=^([0-9]+) nodes infected' -- build/scratch/p4_star
+//   replicate -A --routingProtocol=OLSR -B --routingProtocol=AODV
+//             -m 'efficiency=Efficiency ([0-9.e+-]+)' -- build/scratch/p3 --crn=true
+// Standalone: it does not link against ns-3.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <regex.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Metric
+{
+  std::string name;
+  regex_t pattern;
+};
+
+// Welford's online mean and variance
+struct Accumulator
+{
+  Accumulator () : n (0), mean (0), m2 (0) {}
+
+  void Add (double x)
+  {
+    n++;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+  }
+
+  double Variance (void) const
+  {
+    return n > 1 ? m2 / (n - 1) : 0;
+  }
+
+  uint32_t n;
+  double mean;
+  double m2;
+};
+
+// two-sided 95% Student t quantile
+double
+TQuantile (uint32_t df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df >= 1 && df <= 30)
+    {
+      return table[df - 1];
+    }
+  // Cornish-Fisher expansion around the normal quantile
+  double z = 1.959964;
+  double v = df;
+  return z + (z * z * z + z) / (4 * v)
+    + (5 * std::pow (z, 5) + 16 * z * z * z + 3 * z) / (96 * v * v);
+}
+
+double
+HalfWidth (const Accumulator &a)
+{
+  return a.n > 1 ? TQuantile (a.n - 1) * std::sqrt (a.Variance () / a.n) : HUGE_VAL;
+}
+
+pid_t
+Launch (std::vector<std::string> command, const std::vector<std::string> &arm, uint32_t run, int &out)
+{
+  command.insert (command.end (), arm.begin (), arm.end ());
+  std::ostringstream runArg;
+  runArg << "--RngRun=" << run;
+  std::string rngRun = runArg.str ();
+  std::vector<char *> argv;
+  for (size_t i = 0; i < command.size (); i++)
+    {
+      argv.push_back (const_cast<char *> (command[i].c_str ()));
+    }
+  argv.push_back (const_cast<char *> (rngRun.c_str ()));
+  argv.push_back (0);
+
+  int fds[2];
+  if (pipe (fds) != 0)
+    {
+      return -1;
+    }
+  pid_t child = fork ();
+  if (child == 0)
+    {
+      int null = open ("/dev/null", O_WRONLY);
+      dup2 (fds[1], 1);
+      dup2 (null, 2);
+      close (fds[0]);
+      close (fds[1]);
+      close (null);
+      execv (argv[0], &argv[0]);
+      _exit (127);
+    }
+  close (fds[1]);
+  out = fds[0];
+  return child;
+}
+
+bool
+Collect (pid_t child, int out, std::string &output)
+{
+  char buffer[4096];
+  ssize_t got;
+  while ((got = read (out, buffer, sizeof (buffer))) > 0)
+    {
+      output.append (buffer, got);
+    }
+  close (out);
+  int status;
+  return waitpid (child, &status, 0) == child && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+}
+
+void
+Extract (const std::vector<Metric> &metrics, const std::string &output,
+         std::map<std::string, double> &results)
+{
+  for (size_t m = 0; m < metrics.size (); m++)
+    {
+      std::vector<double> values;
+      std::istringstream lines (output);
+      std::string line;
+      while (std::getline (lines, line))
+        {
+          regmatch_t match[2];
+          if (regexec (&metrics[m].pattern, line.c_str (), 2, match, 0) == 0 && match[1].rm_so >= 0)
+            {
+              values.push_back (std::atof (line.substr (match[1].rm_so, match[1].rm_eo - match[1].rm_so).c_str ()));
+            }
+        }
+      for (size_t i = 0; i < values.size (); i++)
+        {
+          std::ostringstream name;
+          name << metrics[m].name;
+          if (values.size () > 1)
+            {
+              name << "[" << i << "]";
+            }
+          results[name.str ()] = values[i];
+        }
+    }
+}
+
+// armA and armB are empty unless paired, when results holds A - B
+bool
+Converged (const std::map<std::string, Accumulator> &results, const std::map<std::string, Accumulator> &armA,
+           const std::map<std::string, Accumulator> &armB, double relative, double absolute)
+{
+  for (std::map<std::string, Accumulator>::const_iterator i = results.begin (); i != results.end (); ++i)
+    {
+      double halfWidth = HalfWidth (i->second);
+      double scale = std::fabs (i->second.mean);
+      std::map<std::string, Accumulator>::const_iterator a = armA.find (i->first);
+      std::map<std::string, Accumulator>::const_iterator b = armB.find (i->first);
+      if (a != armA.end () && b != armB.end ())
+        {
+          scale = std::max (std::fabs (a->second.mean), std::fabs (b->second.mean));
+        }
+      if (halfWidth > std::max (relative * scale, absolute))
+        {
+          return false;
+        }
+    }
+  return !results.empty ();
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  double relative = 0.05;
+  double absolute = 0;
+  uint32_t minimum = 5;
+  uint32_t maximum = 1000;
+  uint32_t jobs = 1;
+  uint32_t first = 1;
+  std::vector<Metric> metrics;
+  std::vector<std::vector<std::string> > arms (2);
+  int option;
+  while ((option = getopt (argc, argv, "r:a:n:N:j:s:m:A:B:")) != -1)
+    {
+      switch (option)
+        {
+        case 'A': arms[0].push_back (optarg); break;
+        case 'B': arms[1].push_back (optarg); break;
+        case 'r': relative = std::atof (optarg); break;
+        case 'a': absolute = std::atof (optarg); break;
+        case 'n': minimum = std::atoi (optarg); break;
+        case 'N': maximum = std::atoi (optarg); break;
+        case 'j': jobs = std::atoi (optarg); break;
+        case 's': first = std::atoi (optarg); break;
+        case 'm':
+          {
+            const char *equals = std::strchr (optarg, '=');
+            Metric metric;
+            if (equals == 0 || regcomp (&metric.pattern, equals + 1, REG_EXTENDED) != 0)
+              {
+                std::cerr << "Bad metric \"" << optarg << "\", expected name=regex" << std::endl;
+                return 1;
+              }
+            metric.name = std::string (optarg, equals - optarg);
+            metrics.push_back (metric);
+            break;
+          }
+        default:
+          optind = argc;
+        }
+    }
+  bool paired = !arms[0].empty () || !arms[1].empty ();
+  if (optind >= argc || metrics.empty () || jobs < 1 || minimum < 2 || maximum < minimum || absolute < 0
+      || (paired && (arms[0].empty () || arms[1].empty ())))
+    {
+      std::cerr << "Usage: " << argv[0] << " [-r relative] [-a absolute] [-n min] [-N max] [-j jobs] [-s first]"
+                << " [-A arg ... -B arg ...] -m name=regex [-m ...] -- binary [args ...]" << std::endl;
+      return 1;
+    }
+  std::vector<std::string> command (argv + optind, argv + argc);
+  if (!paired)
+    {
+      arms.resize (1);
+    }
+
+  // results holds the metric itself, or A - B when paired
+  std::map<std::string, Accumulator> results;
+  std::map<std::string, Accumulator> armA;
+  std::map<std::string, Accumulator> armB;
+  uint32_t done = 0;
+  bool converged = false;
+  while (done < maximum && !converged)
+    {
+      uint32_t batch = std::min (jobs, maximum - done);
+      std::vector<pid_t> children (batch * arms.size ());
+      std::vector<int> outputs (batch * arms.size ());
+      for (uint32_t i = 0; i < children.size (); i++)
+        {
+          children[i] = Launch (command, arms[i % arms.size ()], first + done + i / arms.size (), outputs[i]);
+          if (children[i] < 0)
+            {
+              std::cerr << "Cannot start " << command[0] << std::endl;
+              return 1;
+            }
+        }
+      for (uint32_t i = 0; i < batch; i++)
+        {
+          std::vector<std::map<std::string, double> > values (arms.size ());
+          for (uint32_t k = 0; k < arms.size (); k++)
+            {
+              std::string output;
+              uint32_t child = i * arms.size () + k;
+              if (!Collect (children[child], outputs[child], output))
+                {
+                  std::cerr << "Replication --RngRun=" << first + done + i << " failed" << std::endl;
+                  return 1;
+                }
+              Extract (metrics, output, values[k]);
+            }
+          for (std::map<std::string, double>::const_iterator v = values[0].begin (); v != values[0].end (); ++v)
+            {
+              if (!paired)
+                {
+                  results[v->first].Add (v->second);
+                }
+              else if (values[1].count (v->first))
+                {
+                  double b = values[1][v->first];
+                  armA[v->first].Add (v->second);
+                  armB[v->first].Add (b);
+                  results[v->first].Add (v->second - b);
+                }
+            }
+        }
+      done += batch;
+      converged = done >= minimum && Converged (results, armA, armB, relative, absolute);
+      std::cerr << "replications " << done << std::endl;
+    }
+
+  for (std::map<std::string, Accumulator>::const_iterator i = results.begin (); i != results.end (); ++i)
+    {
+      double halfWidth = HalfWidth (i->second);
+      if (paired)
+        {
+          const Accumulator &a = armA[i->first];
+          const Accumulator &b = armB[i->first];
+          std::cout << i->first << " A " << a.mean << " B " << b.mean << " A-B";
+        }
+      else
+        {
+          std::cout << i->first;
+        }
+      std::cout << " mean " << i->second.mean << " +- " << halfWidth
+                << " (95% CI, " << (i->second.mean != 0 ? 100 * halfWidth / std::fabs (i->second.mean) : 0)
+                << "% of mean) n " << i->second.n;
+      if (paired)
+        {
+          double independent = armA[i->first].Variance () + armB[i->first].Variance ();
+          std::cout << " variance reduction ";
+          if (i->second.Variance () > 0)
+            {
+              std::cout << independent / i->second.Variance () << "x";
+            }
+          else
+            {
+              std::cout << (independent > 0 ? "inf" : "none");
+            }
+        }
+      std::cout << std::endl;
+    }
+  std::cout << "Replications: " << done << (converged ? " (CI target met)" : " (maximum reached)") << std::endl;
+  return converged ? 0 : 2;
+}
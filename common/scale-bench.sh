@@ -0,0 +1,44 @@
+#!/bin/sh
+# Scaling benchmark: runs every topology at about 10^2, 10^3, 10^4 and 10^5
+# nodes with --scaleReport and collects setup time, run time, events/s and
+# peak RSS into one table.
+#
+# Run from the ns-3 tree the scenarios are built in (scratch/ or examples/):
+#   WAF=./waf sh common/scale-bench.sh > scale.tsv
+# SIZES overrides the node counts, TOPOLOGIES the topologies.  The wifi
+# channel delivers every frame to every node, so wifi is left out of the
+# default 10^5 run; pass TOPOLOGIES=wifi SIZES="100 1000" to time it.
+
+WAF=${WAF:-./waf}
+SIZES=${SIZES:-"100 1000 10000 100000"}
+TOPOLOGIES=${TOPOLOGIES:-"star barbell dumbbell tree"}
+
+# depth of a 10-ary tree with about n nodes
+depth_for ()
+{
+	case $1 in
+		100) echo 2 ;;
+		1000) echo 3 ;;
+		10000) echo 4 ;;
+		*) echo 5 ;;
+	esac
+}
+
+printf "topology\tnodes\tsetup_s\trun_s\tevents\tevents_per_s\tpeak_rss_kib\n"
+for topology in $TOPOLOGIES; do
+	for n in $SIZES; do
+		case $topology in
+			star) args="p4_star --nNodes=$n" ;;
+			barbell) args="p4_barbell --nNodes=$((n / 2))" ;;
+			dumbbell) args="p4 --nFlows=$((n / 2))" ;;
+			tree) args="p4_tree --depth=$(depth_for $n) --fanout=10 --rootFanout=0" ;;
+			wifi) args="p3 --nodeCount=$n --cacheLoss=true --matrixOut=" ;;
+			*) echo "unknown topology $topology" >&2; exit 1 ;;
+		esac
+		# Scale <topology> nodes N setup Xs run Ys events E rate R/s peakRss K KiB
+		$WAF --run "$args --scaleReport=true" 2>/dev/null |
+			awk -v t="$topology" '$1 == "Scale" {
+				sub (/s$/, "", $6); sub (/s$/, "", $8); sub (/\/s$/, "", $12);
+				printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\n", t, $4, $6, $8, $10, $12, $14 }'
+	done
+done
@@ -0,0 +1,160 @@
+#include "scale-probe.h"
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/node-list.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ScaleProbe");
+
+NS_OBJECT_ENSURE_REGISTERED (CountingSimulatorImpl);
+
+namespace {
+
+double
+WallSeconds (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+} // anonymous namespace
+
+TypeId
+CountingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CountingSimulatorImpl")
+    .SetParent<DefaultSimulatorImpl> ()
+    .AddConstructor<CountingSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+CountingSimulatorImpl::CountingSimulatorImpl ()
+  : m_scheduled (0),
+    m_cancelled (0)
+{
+}
+
+CountingSimulatorImpl::~CountingSimulatorImpl ()
+{
+}
+
+EventId
+CountingSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  m_scheduled++;
+  return DefaultSimulatorImpl::Schedule (delay, event);
+}
+
+void
+CountingSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  m_scheduled++;
+  DefaultSimulatorImpl::ScheduleWithContext (context, delay, event);
+}
+
+EventId
+CountingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  m_scheduled++;
+  return DefaultSimulatorImpl::ScheduleNow (event);
+}
+
+void
+CountingSimulatorImpl::Remove (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      m_cancelled++;
+    }
+  DefaultSimulatorImpl::Remove (id);
+}
+
+void
+CountingSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      m_cancelled++;
+    }
+  DefaultSimulatorImpl::Cancel (id);
+}
+
+uint64_t
+CountingSimulatorImpl::GetNEvents (void) const
+{
+  return m_scheduled - m_cancelled;
+}
+
+ScaleProbe::ScaleProbe ()
+  : m_started (false),
+    m_start (0),
+    m_setupDone (0),
+    m_runDone (0),
+    m_events (0),
+    m_nodes (0)
+{
+}
+
+void
+ScaleProbe::Start (void)
+{
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::CountingSimulatorImpl"));
+  m_started = true;
+  m_start = WallSeconds ();
+}
+
+void
+ScaleProbe::SetupDone (void)
+{
+  if (m_started)
+    {
+      m_setupDone = WallSeconds ();
+    }
+}
+
+void
+ScaleProbe::RunDone (void)
+{
+  if (!m_started)
+    {
+      return;
+    }
+  m_runDone = WallSeconds ();
+  m_nodes = NodeList::GetNNodes ();
+  Ptr<CountingSimulatorImpl> impl = DynamicCast<CountingSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      m_events = impl->GetNEvents ();
+    }
+}
+
+void
+ScaleProbe::Print (std::ostream &os, std::string topology) const
+{
+  if (!m_started)
+    {
+      return;
+    }
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  double run = m_runDone - m_setupDone;
+  os << "Scale " << topology
+     << " nodes " << m_nodes
+     << " setup " << m_setupDone - m_start << "s"
+     << " run " << run << "s"
+     << " events " << m_events
+     << " rate " << (run > 0 ? m_events / run : 0) << "/s"
+     // ru_maxrss is in KiB on Linux
+     << " peakRss " << usage.ru_maxrss << " KiB" << std::endl;
+}
+
+} // namespace ns3
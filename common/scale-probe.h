@@ -0,0 +1,72 @@
+#ifndef SCALE_PROBE_H
+#define SCALE_PROBE_H
+
+#include <iostream>
+#include <string>
+
+#include "ns3/default-simulator-impl.h"
+
+namespace ns3 {
+
+/**
+ * DefaultSimulatorImpl that counts the events scheduled and not cancelled
+ * or removed before they ran.  Events still pending when the simulation
+ * stops are counted as well, which is noise against the millions a
+ * scaling run executes.
+ */
+class CountingSimulatorImpl : public DefaultSimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CountingSimulatorImpl ();
+  virtual ~CountingSimulatorImpl ();
+
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+
+  uint64_t GetNEvents (void) const;
+
+private:
+  uint64_t m_scheduled;
+  uint64_t m_cancelled;
+};
+
+/**
+ * Setup time, run time, event rate and peak resident set of one scenario
+ * run, for the scaling benchmark (common/scale-bench.sh).
+ *
+ * Start () must come before anything touches the Simulator, since it
+ * selects CountingSimulatorImpl; until then every call is a no-op, so a
+ * scenario can keep the probe in place and only Start () it on request.
+ */
+class ScaleProbe
+{
+public:
+  ScaleProbe ();
+
+  void Start (void);
+  void SetupDone (void);
+  /// Call after Simulator::Run () and before Simulator::Destroy (), which empties the node list.
+  void RunDone (void);
+  /**
+   * One line: "Scale <topology> nodes N setup Xs run Ys events E rate R/s
+   * peakRss K KiB".
+   */
+  void Print (std::ostream &os, std::string topology) const;
+
+private:
+  bool m_started;
+  double m_start;
+  double m_setupDone;
+  double m_runDone;
+  uint64_t m_events;
+  uint32_t m_nodes;
+};
+
+} // namespace ns3
+
+#endif /* SCALE_PROBE_H */
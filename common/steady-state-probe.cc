@@ -0,0 +1,240 @@
+#include "steady-state-probe.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/packet-sink.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SteadyStateProbe");
+
+NS_OBJECT_ENSURE_REGISTERED (SteadyStateProbe);
+
+namespace {
+
+// two-sided 95% Student t quantile
+double
+TQuantile (uint32_t df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df >= 1 && df <= 30)
+    {
+      return table[df - 1];
+    }
+  return 1.959964 + 2.37227 / df;
+}
+
+} // anonymous namespace
+
+TypeId
+SteadyStateProbe::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SteadyStateProbe")
+    .SetParent<Object> ()
+    .AddConstructor<SteadyStateProbe> ()
+    .AddAttribute ("Interval", "Time between goodput samples",
+                   TimeValue (Seconds (0.1)),
+                   MakeTimeAccessor (&SteadyStateProbe::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BatchSize", "Samples per batch mean (the m of MSER-m)",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&SteadyStateProbe::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MinBatches", "Batches that must remain after the warm-up is deleted",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&SteadyStateProbe::m_minBatches),
+                   MakeUintegerChecker<uint32_t> (2))
+    .AddAttribute ("RelativeError", "Largest 95% half-width, relative to the mean, of a steady flow",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&SteadyStateProbe::m_relativeError),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("StopWhenSteady", "Stop the simulation once every flow is steady",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&SteadyStateProbe::m_stopWhenSteady),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+SteadyStateProbe::SteadyStateProbe ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SteadyStateProbe::~SteadyStateProbe ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+SteadyStateProbe::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  m_flows.clear ();
+  Object::DoDispose ();
+}
+
+void
+SteadyStateProbe::Track (Ptr<PacketSink> sink)
+{
+  NS_LOG_FUNCTION (this << sink);
+  Flow flow;
+  flow.sink = sink;
+  flow.lastRx = 0;
+  flow.truncated = 0;
+  flow.mean = 0;
+  flow.halfWidth = 0;
+  flow.steady = false;
+  m_flows.push_back (flow);
+}
+
+void
+SteadyStateProbe::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_firstSample = Simulator::Now () + m_interval;
+  m_event = Simulator::Schedule (m_interval, &SteadyStateProbe::Sample, this);
+}
+
+void
+SteadyStateProbe::Sample (void)
+{
+  bool allSteady = true;
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      Flow &flow = m_flows[i];
+      uint64_t rx = flow.sink->GetTotalRx ();
+      flow.samples.push_back ((rx - flow.lastRx) / m_interval.GetSeconds ());
+      flow.lastRx = rx;
+      if (flow.samples.size () % m_batchSize == 0)
+        {
+          Analyse (flow);
+        }
+      allSteady = allSteady && flow.steady;
+    }
+  if (allSteady && m_stopWhenSteady)
+    {
+      NS_LOG_INFO ("All " << m_flows.size () << " flows steady at " << Simulator::Now ().GetSeconds () << "s");
+      Simulator::Stop ();
+      return;
+    }
+  m_event = Simulator::Schedule (m_interval, &SteadyStateProbe::Sample, this);
+}
+
+void
+SteadyStateProbe::Analyse (Flow &flow) const
+{
+  uint32_t k = flow.samples.size () / m_batchSize;
+  std::vector<double> batches (k, 0);
+  for (uint32_t j = 0; j < k; j++)
+    {
+      for (uint32_t s = 0; s < m_batchSize; s++)
+        {
+          batches[j] += flow.samples[j * m_batchSize + s];
+        }
+      batches[j] /= m_batchSize;
+    }
+
+  uint32_t best = Truncate (batches);
+  double sum = 0;
+  double sumSquares = 0;
+  for (uint32_t j = best; j < k; j++)
+    {
+      sum += batches[j];
+      sumSquares += batches[j] * batches[j];
+    }
+
+  uint32_t n = k - best;
+  flow.truncated = best;
+  flow.mean = n > 0 ? sum / n : 0;
+  double variance = n > 1 ? (sumSquares - n * flow.mean * flow.mean) / (n - 1) : 0;
+  flow.halfWidth = n > 1 ? TQuantile (n - 1) * std::sqrt (std::max (variance, 0.0) / n) : 0;
+  flow.steady = n >= m_minBatches && flow.mean > 0 && flow.halfWidth <= m_relativeError * flow.mean;
+  NS_LOG_LOGIC ("batches " << k << " warm-up " << best << " mean " << flow.mean
+                << " +- " << flow.halfWidth << (flow.steady ? " steady" : ""));
+}
+
+uint32_t
+SteadyStateProbe::Truncate (const std::vector<double> &batches)
+{
+  uint32_t k = batches.size ();
+  // suffix sums give every MSER(d) in O(k)
+  std::vector<double> sum (k + 1, 0);
+  std::vector<double> sumSquares (k + 1, 0);
+  for (uint32_t j = k; j > 0; j--)
+    {
+      sum[j - 1] = sum[j] + batches[j - 1];
+      sumSquares[j - 1] = sumSquares[j] + batches[j - 1] * batches[j - 1];
+    }
+  uint32_t best = 0;
+  double bestMser = 0;
+  for (uint32_t d = 0; d <= k / 2 && k - d >= 2; d++)
+    {
+      double n = k - d;
+      double mean = sum[d] / n;
+      double mser = (sumSquares[d] - n * mean * mean) / (n * n);
+      if (d == 0 || mser < bestMser)
+        {
+          best = d;
+          bestMser = mser;
+        }
+    }
+  return best;
+}
+
+uint32_t
+SteadyStateProbe::GetNFlows (void) const
+{
+  return m_flows.size ();
+}
+
+bool
+SteadyStateProbe::IsSteady (uint32_t flow) const
+{
+  return m_flows[flow].steady;
+}
+
+bool
+SteadyStateProbe::IsAllSteady (void) const
+{
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      if (!m_flows[i].steady)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+double
+SteadyStateProbe::GetGoodput (uint32_t flow) const
+{
+  return m_flows[flow].mean;
+}
+
+double
+SteadyStateProbe::GetHalfWidth (uint32_t flow) const
+{
+  return m_flows[flow].halfWidth;
+}
+
+Time
+SteadyStateProbe::GetWarmup (uint32_t flow) const
+{
+  return Seconds ((m_firstSample - m_interval).GetSeconds ()
+                  + m_interval.GetSeconds () * m_flows[flow].truncated * m_batchSize);
+}
+
+} // namespace ns3
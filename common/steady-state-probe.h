@@ -0,0 +1,102 @@
+#ifndef STEADY_STATE_PROBE_H
+#define STEADY_STATE_PROBE_H
+
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+namespace ns3 {
+
+class PacketSink;
+
+/**
+ * Samples the goodput of a set of sinks and finds where each flow's
+ * transient ends with MSER-m (the marginal standard error rule over means
+ * of BatchSize consecutive samples).
+ *
+ * Every Interval the bytes received since the last sample become one
+ * goodput sample.  After each sample the batch means b_1..b_k of a flow are
+ * truncated at the d <= k/2 that minimises
+ *
+ *   MSER(d) = sum_{j>d} (b_j - mean_d)^2 / (k - d)^2
+ *
+ * and the remaining k - d batches give the steady-state mean and its 95%
+ * half-width.  A flow is steady once at least MinBatches batches survive
+ * and the half-width is within RelativeError of the mean; with
+ * StopWhenSteady the simulation stops as soon as every flow is.
+ */
+class SteadyStateProbe : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  SteadyStateProbe ();
+  virtual ~SteadyStateProbe ();
+
+  void Track (Ptr<PacketSink> sink);
+
+  /**
+   * Take the first sample Interval from now.
+   */
+  void Start (void);
+
+  uint32_t GetNFlows (void) const;
+  bool IsSteady (uint32_t flow) const;
+  bool IsAllSteady (void) const;
+
+  /**
+   * \return the steady-state goodput in bytes per second, from the last
+   * analysis (also when the flow never became steady)
+   */
+  double GetGoodput (uint32_t flow) const;
+  double GetHalfWidth (uint32_t flow) const;
+
+  /**
+   * \return the end of the deleted warm-up period
+   */
+  Time GetWarmup (uint32_t flow) const;
+
+  /**
+   * The MSER truncation point of a series of batch means b_1..b_k: the
+   * d <= k/2, leaving at least two batches, that minimises MSER(d), the
+   * smallest one on ties.
+   *
+   * \return the number of leading batches to delete, 0 for fewer than
+   * two batches
+   */
+  static uint32_t Truncate (const std::vector<double> &batches);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Flow
+  {
+    Ptr<PacketSink> sink;
+    uint64_t lastRx;
+    std::vector<double> samples;   //!< bytes per second, one per Interval
+    uint32_t truncated;            //!< batches deleted as warm-up
+    double mean;
+    double halfWidth;
+    bool steady;
+  };
+
+  void Sample (void);
+  void Analyse (Flow &flow) const;
+
+  Time m_interval;
+  uint32_t m_batchSize;
+  uint32_t m_minBatches;
+  double m_relativeError;
+  bool m_stopWhenSteady;
+  Time m_firstSample;
+  std::vector<Flow> m_flows;
+  EventId m_event;
+};
+
+} // namespace ns3
+
+#endif /* STEADY_STATE_PROBE_H */
@@ -0,0 +1,464 @@
+// Run a parameter sweep of one scenario over all cores, caching every
+// point's output on disk so an interrupted sweep picks up where it stopped.
+//
+// Usage: sweep-runner [-j jobs] [-n] <grid>
+//
+// The grid file declares the sweep, one directive per line ('#' starts a
+// comment):
+//
+//   binary  build/scratch/p3        program to run, exec'd directly
+//   cache   p3-sweep                result directory (default sweep-cache)
+//   arg     --matrixOut=            passed unchanged to every point
+//   param   nodeCount 100 500 1000  one --nodeCount=V per value
+//   param   routingProtocol OLSR AODV
+//   seeds   1-20                    --RngRun values, lists and a-b ranges
+//
+// Every combination of the param values and seeds is a point.  A point is
+// keyed by a 64-bit FNV-1a hash of the binary's contents and its argument
+// list, and its stdout is stored as <cache>/<key>.out, written to a
+// temporary file and renamed once the run exits cleanly.  Points whose
+// file already exists are skipped, so rerunning after an interruption, or
+// after adding values to the grid, only runs what is missing; rebuilding
+// the binary invalidates everything.  When all points are done their
+// outputs are printed in grid order, each behind a "# args" line.
+//
+// Points are dealt round-robin to one deque per worker (-j, default one per
+// core); a worker takes from the back of its own deque and, once that is
+// empty, steals from the front of the others, so long points on one worker
+// do not leave the rest idle at the end of the sweep.
+// Standalone: it does not link against ns-3.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Param
+{
+  std::string name;
+  std::vector<std::string> values;
+};
+
+struct Point
+{
+  std::vector<std::string> args;
+  std::string key;
+};
+
+struct WorkQueue
+{
+  pthread_mutex_t lock;
+  std::deque<size_t> points;
+};
+
+struct Sweep
+{
+  std::string binary;
+  std::string cache;
+  std::vector<std::string> fixedArgs;
+  std::vector<Point> points;
+  std::vector<WorkQueue> queues;
+  pthread_mutex_t progressLock;
+  size_t toRun;
+  size_t finished;
+  size_t failed;
+};
+
+struct Worker
+{
+  Sweep *sweep;
+  size_t self;
+};
+
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t
+Fnv1a (uint64_t hash, const char *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    {
+      hash ^= static_cast<unsigned char> (data[i]);
+      hash *= FNV_PRIME;
+    }
+  return hash;
+}
+
+bool
+HashFile (const std::string &path, uint64_t &hash)
+{
+  std::ifstream in (path.c_str (), std::ios::binary);
+  if (!in)
+    {
+      return false;
+    }
+  hash = FNV_OFFSET;
+  char buffer[65536];
+  while (in.read (buffer, sizeof (buffer)) || in.gcount () > 0)
+    {
+      hash = Fnv1a (hash, buffer, in.gcount ());
+    }
+  return true;
+}
+
+bool
+FileExists (const std::string &path)
+{
+  struct stat st;
+  return stat (path.c_str (), &st) == 0;
+}
+
+// "1-5" expands to 1 2 3 4 5; anything else is taken as it is
+void
+ExpandSeeds (const std::string &word, std::vector<std::string> &values)
+{
+  unsigned long first;
+  unsigned long last;
+  char dash;
+  std::istringstream range (word);
+  if (word.find ('-') != std::string::npos && (range >> first >> dash >> last) && dash == '-' && range.eof ())
+    {
+      for (unsigned long seed = first; seed <= last; seed++)
+        {
+          std::ostringstream value;
+          value << seed;
+          values.push_back (value.str ());
+        }
+      return;
+    }
+  values.push_back (word);
+}
+
+bool
+ReadGrid (const char *filename, Sweep &sweep, std::vector<Param> &params)
+{
+  std::ifstream in (filename);
+  if (!in)
+    {
+      std::cerr << "Cannot open grid " << filename << std::endl;
+      return false;
+    }
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (std::getline (in, line))
+    {
+      lineNumber++;
+      line = line.substr (0, line.find ('#'));
+      std::istringstream words (line);
+      std::string directive;
+      if (!(words >> directive))
+        {
+          continue;
+        }
+      std::string word;
+      if (directive == "binary" && (words >> word))
+        {
+          sweep.binary = word;
+        }
+      else if (directive == "cache" && (words >> word))
+        {
+          sweep.cache = word;
+        }
+      else if (directive == "arg" && (words >> word))
+        {
+          sweep.fixedArgs.push_back (word);
+        }
+      else if (directive == "param" && (words >> word))
+        {
+          Param param;
+          param.name = word;
+          while (words >> word)
+            {
+              param.values.push_back (word);
+            }
+          params.push_back (param);
+        }
+      else if (directive == "seeds")
+        {
+          Param param;
+          param.name = "RngRun";
+          while (words >> word)
+            {
+              ExpandSeeds (word, param.values);
+            }
+          params.push_back (param);
+        }
+      else
+        {
+          std::cerr << filename << ":" << lineNumber << ": cannot parse \"" << line << "\"" << std::endl;
+          return false;
+        }
+      if (!params.empty () && params.back ().values.empty ())
+        {
+          std::cerr << filename << ":" << lineNumber << ": " << params.back ().name << " has no values" << std::endl;
+          return false;
+        }
+    }
+  if (sweep.binary.empty ())
+    {
+      std::cerr << filename << ": no binary given" << std::endl;
+      return false;
+    }
+  return true;
+}
+
+// odometer over the value lists, last param varying fastest
+void
+ExpandGrid (const std::vector<std::string> &fixedArgs, const std::vector<Param> &params,
+            uint64_t binaryHash, std::vector<Point> &points)
+{
+  std::vector<size_t> index (params.size (), 0);
+  for (;;)
+    {
+      Point point;
+      point.args = fixedArgs;
+      for (size_t p = 0; p < params.size (); p++)
+        {
+          point.args.push_back ("--" + params[p].name + "=" + params[p].values[index[p]]);
+        }
+      uint64_t hash = Fnv1a (FNV_OFFSET, reinterpret_cast<const char *> (&binaryHash), sizeof (binaryHash));
+      for (size_t i = 0; i < point.args.size (); i++)
+        {
+          // the terminating NUL keeps "a" "bc" and "ab" "c" apart
+          hash = Fnv1a (hash, point.args[i].c_str (), point.args[i].size () + 1);
+        }
+      char key[17];
+      std::snprintf (key, sizeof (key), "%016llx", static_cast<unsigned long long> (hash));
+      point.key = key;
+      points.push_back (point);
+
+      size_t p = params.size ();
+      while (p > 0 && ++index[p - 1] == params[p - 1].values.size ())
+        {
+          index[p - 1] = 0;
+          p--;
+        }
+      if (p == 0)
+        {
+          return;
+        }
+    }
+}
+
+std::string
+Describe (const Point &point)
+{
+  std::string text;
+  for (size_t i = 0; i < point.args.size (); i++)
+    {
+      text += (i == 0 ? "" : " ") + point.args[i];
+    }
+  return text;
+}
+
+bool
+Take (Sweep &sweep, size_t self, size_t &point)
+{
+  WorkQueue &own = sweep.queues[self];
+  pthread_mutex_lock (&own.lock);
+  bool found = !own.points.empty ();
+  if (found)
+    {
+      point = own.points.back ();
+      own.points.pop_back ();
+    }
+  pthread_mutex_unlock (&own.lock);
+
+  for (size_t i = 1; !found && i < sweep.queues.size (); i++)
+    {
+      WorkQueue &victim = sweep.queues[(self + i) % sweep.queues.size ()];
+      pthread_mutex_lock (&victim.lock);
+      found = !victim.points.empty ();
+      if (found)
+        {
+          point = victim.points.front ();
+          victim.points.pop_front ();
+        }
+      pthread_mutex_unlock (&victim.lock);
+    }
+  return found;
+}
+
+bool
+RunPoint (const Sweep &sweep, const Point &point, size_t worker)
+{
+  // built before fork (): the child may only make async-signal-safe calls
+  std::ostringstream name;
+  name << sweep.cache << "/" << point.key << ".tmp." << getpid () << "." << worker;
+  std::string temporary = name.str ();
+  std::string result = sweep.cache + "/" + point.key + ".out";
+
+  std::vector<char *> argv;
+  argv.push_back (const_cast<char *> (sweep.binary.c_str ()));
+  for (size_t i = 0; i < point.args.size (); i++)
+    {
+      argv.push_back (const_cast<char *> (point.args[i].c_str ()));
+    }
+  argv.push_back (0);
+  std::string header = "# " + Describe (point) + "\n";
+
+  pid_t child = fork ();
+  if (child == 0)
+    {
+      int out = open (temporary.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      int null = open ("/dev/null", O_WRONLY);
+      if (out < 0 || null < 0 || write (out, header.c_str (), header.size ()) < 0)
+        {
+          _exit (127);
+        }
+      dup2 (out, 1);
+      // scenario logging goes to stderr and would interleave across workers
+      dup2 (null, 2);
+      close (out);
+      close (null);
+      execv (sweep.binary.c_str (), &argv[0]);
+      _exit (127);
+    }
+  int status = 0;
+  bool ok = child > 0 && waitpid (child, &status, 0) == child
+    && WIFEXITED (status) && WEXITSTATUS (status) == 0
+    && std::rename (temporary.c_str (), result.c_str ()) == 0;
+  if (!ok)
+    {
+      std::remove (temporary.c_str ());
+    }
+  return ok;
+}
+
+void *
+WorkerMain (void *arg)
+{
+  Worker *worker = static_cast<Worker *> (arg);
+  Sweep &sweep = *worker->sweep;
+  size_t point;
+  while (Take (sweep, worker->self, point))
+    {
+      bool ok = RunPoint (sweep, sweep.points[point], worker->self);
+      pthread_mutex_lock (&sweep.progressLock);
+      sweep.finished++;
+      sweep.failed += ok ? 0 : 1;
+      std::cerr << "[" << sweep.finished << "/" << sweep.toRun << "] " << sweep.points[point].key
+                << (ok ? " " : " FAILED ") << Describe (sweep.points[point]) << std::endl;
+      pthread_mutex_unlock (&sweep.progressLock);
+    }
+  return 0;
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  long jobs = sysconf (_SC_NPROCESSORS_ONLN);
+  bool dryRun = false;
+  int option;
+  while ((option = getopt (argc, argv, "j:n")) != -1)
+    {
+      if (option == 'j')
+        {
+          jobs = std::atol (optarg);
+        }
+      else if (option == 'n')
+        {
+          dryRun = true;
+        }
+      else
+        {
+          optind = argc + 1;
+        }
+    }
+  if (optind != argc - 1 || jobs < 1)
+    {
+      std::cerr << "Usage: " << argv[0] << " [-j jobs] [-n] <grid>" << std::endl;
+      return 1;
+    }
+
+  Sweep sweep;
+  sweep.cache = "sweep-cache";
+  std::vector<Param> params;
+  if (!ReadGrid (argv[optind], sweep, params))
+    {
+      return 1;
+    }
+  uint64_t binaryHash;
+  if (!HashFile (sweep.binary, binaryHash))
+    {
+      std::cerr << "Cannot read binary " << sweep.binary << std::endl;
+      return 1;
+    }
+  ExpandGrid (sweep.fixedArgs, params, binaryHash, sweep.points);
+  if (mkdir (sweep.cache.c_str (), 0755) != 0 && errno != EEXIST)
+    {
+      std::cerr << "Cannot create cache directory " << sweep.cache << std::endl;
+      return 1;
+    }
+
+  sweep.queues.resize (jobs);
+  sweep.toRun = 0;
+  sweep.finished = 0;
+  sweep.failed = 0;
+  for (size_t i = 0; i < sweep.points.size (); i++)
+    {
+      if (FileExists (sweep.cache + "/" + sweep.points[i].key + ".out"))
+        {
+          continue;
+        }
+      if (dryRun)
+        {
+          std::cout << sweep.points[i].key << " " << Describe (sweep.points[i]) << std::endl;
+        }
+      sweep.queues[sweep.toRun++ % jobs].points.push_back (i);
+    }
+  std::cerr << sweep.points.size () << " points, " << sweep.points.size () - sweep.toRun
+            << " cached, " << sweep.toRun << " to run on " << jobs << " workers" << std::endl;
+  if (dryRun)
+    {
+      return 0;
+    }
+
+  pthread_mutex_init (&sweep.progressLock, 0);
+  std::vector<pthread_t> threads (jobs);
+  std::vector<Worker> workers (jobs);
+  for (long i = 0; i < jobs; i++)
+    {
+      pthread_mutex_init (&sweep.queues[i].lock, 0);
+      workers[i].sweep = &sweep;
+      workers[i].self = i;
+      pthread_create (&threads[i], 0, WorkerMain, &workers[i]);
+    }
+  for (long i = 0; i < jobs; i++)
+    {
+      pthread_join (threads[i], 0);
+    }
+
+  for (size_t i = 0; i < sweep.points.size (); i++)
+    {
+      std::ifstream result ((sweep.cache + "/" + sweep.points[i].key + ".out").c_str ());
+      if (result)
+        {
+          std::cout << result.rdbuf ();
+        }
+    }
+  if (sweep.failed > 0)
+    {
+      std::cerr << sweep.failed << " points failed and will be retried on the next run" << std::endl;
+      return 1;
+    }
+  return 0;
+}
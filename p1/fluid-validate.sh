@@ -0,0 +1,39 @@
+#!/bin/sh
+# Validation of p1 --mode=fluid against the packet simulation: runs both
+# modes with the same seed (so the same flow start times) over a reference
+# grid and reports the mean per-flow goodput of each and their relative
+# difference.  Points where the two agree can be screened with the fluid
+# model alone; the rest are the ones worth simulating.
+#
+# Run from the ns-3 tree p1 is built in:
+#   WAF=./waf sh p1/fluid-validate.sh > fluid-validation.tsv
+# FLOWS, QUEUES, WINDOWS and SEGMENTS override the grid.
+
+WAF=${WAF:-./waf}
+FLOWS=${FLOWS:-"1 2 4 8 16"}
+QUEUES=${QUEUES:-"8000 32000 64000"}
+WINDOWS=${WINDOWS:-"16000 64000"}
+SEGMENTS=${SEGMENTS:-"128 512"}
+
+# mean of the goodput fields of "flow i ... goodput X" lines
+mean_goodput ()
+{
+	awk '$1 == "flow" { sum += $NF; n++ } END { if (n) printf "%.1f", sum / n; else print "nan" }'
+}
+
+printf "nFlows\tqueueSize\twindowSize\tsegSize\tfluid\tpacket\trel_error\n"
+for n in $FLOWS; do
+	for q in $QUEUES; do
+		for w in $WINDOWS; do
+			for s in $SEGMENTS; do
+				args="p1 --nFlows=$n --queueSize=$q --windowSize=$w --segSize=$s"
+				fluid=$($WAF --run "$args --mode=fluid" 2>/dev/null | mean_goodput)
+				packet=$($WAF --run "$args --mode=packet" 2>/dev/null | mean_goodput)
+				printf "%s\t%s\t%s\t%s\t%s\t%s\t" $n $q $w $s $fluid $packet
+				awk -v f=$fluid -v p=$packet 'BEGIN { if (p > 0) printf "%.3f\n", (f - p) / p; else print "nan" }'
+			done
+		done
+	done
+done |
+	awk -F '\t' '{ print } $7 != "nan" { e = $7 < 0 ? -$7 : $7; sum += e; n++; if (e > max) max = e }
+		END { if (n) printf "# %d points, mean |rel_error| %.3f, max %.3f\n", n, sum / n, max }'
@@ -7,6 +7,8 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
+#include <sys/time.h>
 #include<iostream>
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -21,6 +23,10 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/tcp-socket.h"
 
+#include "../common/address-plan.h"
+#include "../common/steady-state-probe.h"
+#include "tcp-fluid-model.h"
+
 
 using namespace ns3;
 
@@ -30,16 +36,16 @@ int main (int argc, char *argv[])
 {
 
 
-  RngSeedManager::SetSeed (11223344);
-  Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
-  U->SetAttribute ("Min", DoubleValue (0.0));
-  U->SetAttribute ("Max", DoubleValue (0.1));
-
   //bool tracing = false;
   uint32_t nFlows = 1;
   uint32_t segSize = 128;
   uint32_t queueSize = 32000;
   uint32_t windowSize = 64000;
+  uint32_t seed = 11223344;
+  std::string mode = "packet";
+  bool steadyState = false;
+  double sampleInterval = 0.1;
+  double steadyError = 0.05;
 
 //
 // Allow the user to override any of the defaults at
@@ -50,8 +56,41 @@ int main (int argc, char *argv[])
   cmd.AddValue ("segSize", "Size of each segment", segSize);
   cmd.AddValue ("queueSize","Size of buffer", queueSize);
   cmd.AddValue ("windowSize", "Size of Window", windowSize);
+  cmd.AddValue ("seed", "Random number seed; --RngRun selects an independent replication", seed);
+  cmd.AddValue ("mode", "packet simulation, or fluid for the flow-level TCP/queue model of the same dumbbell", mode);
+  cmd.AddValue ("steadyState", "Stop once every flow's goodput is steady (MSER warm-up deletion), 10 s at most", steadyState);
+  cmd.AddValue ("sampleInterval", "Goodput sampling interval (s) for --steadyState", sampleInterval);
+  cmd.AddValue ("steadyError", "Relative 95% half-width at which a flow counts as steady", steadyError);
   cmd.Parse (argc, argv);
 
+  // seed and run are read when a stream is created, so only after parsing
+  RngSeedManager::SetSeed (seed);
+  Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
+  U->SetAttribute ("Min", DoubleValue (0.0));
+  U->SetAttribute ("Max", DoubleValue (0.1));
+
+  if (mode == "fluid") {
+    // same links and start times as the packet run below
+    struct timeval begin, end;
+    gettimeofday (&begin, 0);
+    TcpFluidModel fluid;
+    fluid.SetAccessLink (5e6, MilliSeconds (10));
+    fluid.SetBottleneck (1e6, MilliSeconds (20));
+    fluid.SetQueueBytes (queueSize);
+    fluid.SetSegmentSize (segSize);
+    fluid.SetMaxWindowBytes (windowSize);
+    for(uint32_t i=0;i<nFlows;i++)
+      fluid.AddFlow (Seconds (U->GetValue ()));
+    fluid.Run (Seconds (10.0));
+    gettimeofday (&end, 0);
+    for(uint32_t i=0;i<nFlows;i++)
+      std::cout << "flow " << i << " windowSize " << windowSize << " queueSize " << queueSize << " segSize " << segSize << " goodput " << fluid.GetGoodput (i) << std::endl;
+    std::cout << "fluid queue " << fluid.GetMeanQueueBytes () << " bytes loss " << fluid.GetLossRate ()
+              << " took " << (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_usec - begin.tv_usec) / 1e3 << " ms" << std::endl;
+    return 0;
+  }
+  NS_ABORT_MSG_UNLESS (mode == "packet", "Unknown --mode=" << mode << ", use packet or fluid");
+
   Config::SetDefault ("ns3::DropTailQueue::Mode", EnumValue(DropTailQueue::QUEUE_MODE_BYTES));
   Config::SetDefault ("ns3::DropTailQueue::MaxBytes", UintegerValue(queueSize));
  
@@ -66,8 +105,8 @@ int main (int argc, char *argv[])
   int nodes=2*nFlows+2;
   c.Create(nodes);
 
-  NodeContainer n0n1[nFlows];
-  NodeContainer n3n2[nFlows];
+  std::vector<NodeContainer> n0n1 (nFlows);
+  std::vector<NodeContainer> n3n2 (nFlows);
 
   for(uint32_t i=0;i<nFlows;i++){
    n0n1[i]= NodeContainer (c.Get (i), c.Get (nFlows));
@@ -95,8 +134,8 @@ int main (int argc, char *argv[])
   //p2p2.SetQueue("ns3::DropTailQueue","MaxBytes", UintegerValue(queueSize));
   
   NetDeviceContainer d1d2 = p2p2.Install (n1n2);
-  NetDeviceContainer d0d1[nFlows];
-  NetDeviceContainer d2d3[nFlows];
+  std::vector<NetDeviceContainer> d0d1 (nFlows);
+  std::vector<NetDeviceContainer> d2d3 (nFlows);
 
 for(uint32_t i=0;i<nFlows;i++){
   d0d1[i] = p2p.Install (n0n1[i]);
@@ -106,34 +145,20 @@ for(uint32_t i=0;i<nFlows;i++){
 
   NS_LOG_INFO ("Assign IP Addresses.");
 
-  Ipv4AddressHelper ipv4;
-  //uint32_t pp= 10.10.1.1;
-  //std::cout<<pp << std::endl;
+  AddressPlan plan;
   
-  Ipv4InterfaceContainer i0i1[nFlows];
-  Ipv4InterfaceContainer i3i2[nFlows];
+  std::vector<Ipv4InterfaceContainer> i0i1 (nFlows);
+  std::vector<Ipv4InterfaceContainer> i3i2 (nFlows);
 
 
 for(uint32_t i=0;i<nFlows;i++){
-  
-  std::ostringstream subnet;
-  subnet<<"10.1."<<i+1<<".0";
-  ipv4.SetBase (subnet.str ().c_str (), "255.255.255.0");
-  //ipv4.SetBase ("10.1.1.0", "255.255.255.0" , i+1);
-  i0i1[i]= ipv4.Assign (d0d1[i]);
+  i0i1[i]= plan.AssignPointToPoint (d0d1[i]);
 }
-  std::ostringstream subnet;
-  subnet<<"10.1."<<nFlows+1<<".0";
-  ipv4.SetBase (subnet.str ().c_str (), "255.255.255.0");
 
-  ipv4.SetBase ("10.10.2.0", "255.255.255.0");
-  Ipv4InterfaceContainer i1i2 = ipv4.Assign (d1d2);
+  Ipv4InterfaceContainer i1i2 = plan.AssignPointToPoint (d1d2);
 
 for(uint32_t i=0;i<nFlows;i++){
-  std::ostringstream subnet;
-  subnet<<"10.1."<<nFlows+2+i<<".0";
-  ipv4.SetBase (subnet.str ().c_str (), "255.255.255.0");
-  i3i2[i] = ipv4.Assign (d2d3[i]);
+  i3i2[i] = plan.AssignPointToPoint (d2d3[i]);
 }
 
 
@@ -146,9 +171,9 @@ for(uint32_t i=0;i<nFlows;i++){
   //Bulk packet send at node0
  
   uint16_t port = 9;
-   ApplicationContainer sourceApps[nFlows];
-   ApplicationContainer sinkApps[nFlows]; 
-  double rnum[nFlows]; 
+   std::vector<ApplicationContainer> sourceApps (nFlows);
+   std::vector<ApplicationContainer> sinkApps (nFlows);
+  std::vector<double> rnum (nFlows);
 
 for(uint32_t i=0;i<nFlows;i++){
    BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (i3i2[i].GetAddress(0), port));
@@ -172,21 +197,39 @@ for(uint32_t i=0;i<nFlows;i++){
    sinkApps[i].Stop (Seconds (10.0));
 }
 
+  Ptr<SteadyStateProbe> steady;
+  if (steadyState) {
+    steady = CreateObject<SteadyStateProbe> ();
+    steady->SetAttribute ("Interval", TimeValue (Seconds (sampleInterval)));
+    steady->SetAttribute ("RelativeError", DoubleValue (steadyError));
+    for(uint32_t i=0;i<nFlows;i++)
+      steady->Track (DynamicCast<PacketSink> (sinkApps[i].Get(0)));
+    steady->Start ();
+  }
+
 
    NS_LOG_INFO("run Simulation");
 
    Simulator::Stop(Seconds (10.0));
    Simulator::Run();
+   // earlier than 10 s when --steadyState stopped the run
+   double endTime = Simulator::Now ().GetSeconds ();
    Simulator::Destroy();
 
    NS_LOG_INFO("End");
 
 
 
-Ptr<PacketSink> sink1[nFlows];   
+std::vector<Ptr<PacketSink> > sink1 (nFlows);
 for(uint32_t i=0;i<nFlows;i++){
    sink1[i] = DynamicCast<PacketSink> (sinkApps[i].Get(0));
-   std::cout << "flow " << i << " windowSize " << windowSize << " queueSize " << queueSize << " segSize " << segSize << " goodput " << (sink1[i]->GetTotalRx())/(10.0-rnum[i]) << std::endl;
+   std::cout << "flow " << i << " windowSize " << windowSize << " queueSize " << queueSize << " segSize " << segSize << " goodput " << (sink1[i]->GetTotalRx())/(endTime-rnum[i]);
+   if (steadyState)
+     std::cout << " steadyGoodput " << steady->GetGoodput (i) << " +- " << steady->GetHalfWidth (i)
+               << " warmup " << steady->GetWarmup (i).GetSeconds () << (steady->IsSteady (i) ? " steady" : " unsteady");
+   std::cout << std::endl;
 }
+if (steadyState)
+  std::cout << "stopped at " << endTime << " s" << std::endl;
  
 }
@@ -0,0 +1,184 @@
+#include "tcp-fluid-model.h"
+
+#include <algorithm>
+
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpFluidModel");
+
+namespace {
+
+// TCP/IPv4 headers plus the PPP header of a point-to-point link
+const uint32_t HEADER_BYTES = 40 + 2;
+
+} // anonymous namespace
+
+TcpFluidModel::TcpFluidModel ()
+  : m_segmentSize (536),
+    m_queueBytes (32000),
+    m_maxWindowBytes (65535),
+    m_accessRate (5e6),
+    m_bottleneckRate (1e6),
+    m_accessDelay (MilliSeconds (10)),
+    m_bottleneckDelay (MilliSeconds (20)),
+    m_step (MilliSeconds (1)),
+    m_meanQueue (0),
+    m_lossRate (0)
+{
+}
+
+void
+TcpFluidModel::SetAccessLink (double accessRate, Time accessDelay)
+{
+  m_accessRate = accessRate;
+  m_accessDelay = accessDelay;
+}
+
+void
+TcpFluidModel::SetBottleneck (double rate, Time delay)
+{
+  m_bottleneckRate = rate;
+  m_bottleneckDelay = delay;
+}
+
+void
+TcpFluidModel::SetQueueBytes (uint32_t bytes)
+{
+  m_queueBytes = bytes;
+}
+
+void
+TcpFluidModel::SetSegmentSize (uint32_t bytes)
+{
+  m_segmentSize = bytes;
+}
+
+void
+TcpFluidModel::SetMaxWindowBytes (uint32_t bytes)
+{
+  m_maxWindowBytes = bytes;
+}
+
+void
+TcpFluidModel::SetStep (Time step)
+{
+  m_step = step;
+}
+
+void
+TcpFluidModel::AddFlow (Time start)
+{
+  m_start.push_back (start);
+}
+
+void
+TcpFluidModel::Run (Time stop)
+{
+  NS_LOG_FUNCTION (this << stop);
+  uint32_t n = m_start.size ();
+  double dt = m_step.GetSeconds ();
+  double wire = m_segmentSize + HEADER_BYTES;
+  // everything below is in segments and seconds
+  double capacity = m_bottleneckRate / 8 / wire;
+  double buffer = m_queueBytes / wire;
+  double maxWindow = std::max (1.0, (double) m_maxWindowBytes / m_segmentSize);
+  double propagation = 2 * (2 * m_accessDelay.GetSeconds () + m_bottleneckDelay.GetSeconds ())
+    + wire * 8 * (2 / m_accessRate + 1 / m_bottleneckRate);
+  uint32_t steps = (uint32_t) (stop.GetSeconds () / dt);
+
+  std::vector<double> window (n, 1);
+  std::vector<bool> slowStart (n, true);
+  std::vector<double> rate (n, 0);
+  // per-step loss signal x_i * p of every flow, read back one RTT later;
+  // a ring as long as the largest RTT, a full queue included
+  uint32_t history = (uint32_t) ((propagation + buffer / capacity) / dt) + 2;
+  std::vector<std::vector<double> > lost (history, std::vector<double> (n, 0));
+  m_delivered.assign (n, 0);
+  double queue = 0;
+  double queueSum = 0;
+  double arrivedTotal = 0;
+  double lostTotal = 0;
+
+  for (uint32_t s = 0; s < steps; s++)
+    {
+      double now = s * dt;
+      double rtt = propagation + queue / capacity;
+      double arrival = 0;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          lost[s % history][i] = 0;
+          rate[i] = now >= m_start[i].GetSeconds () ? window[i] / rtt : 0;
+          arrival += rate[i];
+        }
+
+      // DropTail discards whatever would overflow the buffer
+      double next = queue + (arrival - capacity) * dt;
+      double p = 0;
+      if (next > buffer && arrival > 0)
+        {
+          p = (next - buffer) / (arrival * dt);
+          next = buffer;
+        }
+      double served = (queue > 0 || arrival > capacity) ? capacity : arrival;
+      queue = std::max (0.0, next);
+      queueSum += queue;
+      arrivedTotal += arrival * dt;
+      lostTotal += arrival * p * dt;
+
+      uint32_t delay = (uint32_t) (rtt / dt);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (rate[i] == 0)
+            {
+              continue;
+            }
+          lost[s % history][i] = rate[i] * p;
+          m_delivered[i] += served * rate[i] / arrival * dt * m_segmentSize;
+          double signal = s >= delay ? lost[(s - delay) % history][i] : 0;
+          if (slowStart[i])
+            {
+              if (signal > 0)
+                {
+                  slowStart[i] = false;
+                  window[i] /= 2;
+                }
+              else
+                {
+                  window[i] += window[i] / rtt * dt;
+                }
+            }
+          else
+            {
+              window[i] += (1 / rtt - window[i] / 2 * signal) * dt;
+            }
+          window[i] = std::min (maxWindow, std::max (1.0, window[i]));
+        }
+    }
+
+  m_stop = stop;
+  m_meanQueue = steps > 0 ? queueSum / steps * wire : 0;
+  m_lossRate = arrivedTotal > 0 ? lostTotal / arrivedTotal : 0;
+}
+
+double
+TcpFluidModel::GetGoodput (uint32_t flow) const
+{
+  double lifetime = (m_stop - m_start[flow]).GetSeconds ();
+  return lifetime > 0 ? m_delivered[flow] / lifetime : 0;
+}
+
+double
+TcpFluidModel::GetMeanQueueBytes (void) const
+{
+  return m_meanQueue;
+}
+
+double
+TcpFluidModel::GetLossRate (void) const
+{
+  return m_lossRate;
+}
+
+} // namespace ns3
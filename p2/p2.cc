@@ -29,6 +29,9 @@
 #include "ns3/constant-position-mobility-model.h"
 #include "ns3/point-to-point-layout-module.h"
 
+#include "../common/address-plan.h"
+#include "../common/steady-state-probe.h"
+
 
 
 using namespace ns3;
@@ -51,6 +54,10 @@ int main (int argc, char *argv[])
   double Wq = 1./128.;     
   double maxP = 2;         
 
+  bool steadyState = false;
+  double sampleInterval = 0.1;
+  double steadyError = 0.05;
+
 
   CommandLine cmd;
 
@@ -58,6 +65,9 @@ int main (int argc, char *argv[])
   cmd.AddValue ("winSize", "Receiver window size (Bytes)", maxBytes);
   cmd.AddValue ("load", "Load", load);
   cmd.AddValue ("Wq", "Weighting factor for average queue length", wgt);
+  cmd.AddValue ("steadyState", "Stop once every flow's goodput is steady (MSER warm-up deletion), 10 s at most", steadyState);
+  cmd.AddValue ("sampleInterval", "Goodput sampling interval (s) for --steadyState", sampleInterval);
+  cmd.AddValue ("steadyError", "Relative 95% half-width at which a flow counts as steady", steadyError);
 
   
 
@@ -180,14 +190,11 @@ int main (int argc, char *argv[])
   stack.Install (n);
   
 
-  Ipv4AddressHelper ipv4;
+  AddressPlan plan;
   std::vector<Ipv4InterfaceContainer> ifcon (numNodes-1);
 
   for(uint32_t i=0; i<devices.size(); ++i) {
-    std::ostringstream subnet;
-    subnet << "10.1." << i+1 << ".0";
-    ipv4.SetBase(subnet.str().c_str(), "255.255.255.0");
-    ifcon[i] = ipv4.Assign(devices[i]);
+    ifcon[i] = plan.AssignPointToPoint (devices[i]);
   }
 
 
@@ -245,14 +252,29 @@ int main (int argc, char *argv[])
 
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
+  Ptr<SteadyStateProbe> steady;
+  if (steadyState)
+  {
+    steady = CreateObject<SteadyStateProbe> ();
+    steady->SetAttribute ("Interval", TimeValue (Seconds (sampleInterval)));
+    steady->SetAttribute ("RelativeError", DoubleValue (steadyError));
+    for(ApplicationContainer::Iterator i = sinkApps.Begin(); i != sinkApps.End(); ++i)
+      steady->Track (DynamicCast<PacketSink> (*i));
+    steady->Start ();
+  }
+
 
 // RUN SIMULATION
 
   std::cout << "\nRuning simulation..." << std::endl;
   Simulator::Stop (Seconds (10.0));
   Simulator::Run ();
+  // earlier than 10 s when --steadyState stopped the run
+  double endTime = Simulator::Now ().GetSeconds ();
   Simulator::Destroy ();
   std::cout << "\nSimulation finished!" << std::endl;
+  if (steadyState)
+    std::cout << "Stopped at " << endTime << " s" << std::endl;
 
   std::cerr << "queueType = " << queueType << "\t"
             << "load = " << load << "\t"
@@ -272,9 +294,13 @@ int main (int argc, char *argv[])
   for(ApplicationContainer::Iterator i = sinkApps.Begin(); i != sinkApps.End(); ++i) {
     Ptr<PacketSink> sink = DynamicCast<PacketSink> (*i);
     uint32_t bytesRcvd = sink->GetTotalRx ();
-    goodputs.push_back(bytesRcvd / 10.0);
+    goodputs.push_back(bytesRcvd / endTime);
     std::cout << "\nFlow " << j << ":";
     std::cout << "\tGoodput: " << goodputs.back() << " Bytes/seconds" << std::endl;
+    if (steadyState)
+      std::cout << "\tSteady goodput: " << steady->GetGoodput (j) << " +- " << steady->GetHalfWidth (j)
+                << " Bytes/seconds, warm-up " << steady->GetWarmup (j).GetSeconds () << " s"
+                << (steady->IsSteady (j) ? "" : " (not steady)") << std::endl;
     ++j;
   }
 
@@ -0,0 +1,229 @@
+#include "cached-propagation-model.h"
+
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/node.h"
+#include "ns3/mobility-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachedPropagationModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationDelayModel);
+
+namespace {
+
+const uint32_t NO_NODE = 0xffffffff;
+
+} // anonymous namespace
+
+TypeId
+CachedPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .AddConstructor<CachedPropagationLossModel> ()
+    .AddAttribute ("Inner", "The deterministic loss model whose results are cached",
+                   PointerValue (),
+                   MakePointerAccessor (&CachedPropagationLossModel::SetInner,
+                                        &CachedPropagationLossModel::GetInner),
+                   MakePointerChecker<PropagationLossModel> ())
+  ;
+  return tid;
+}
+
+CachedPropagationLossModel::CachedPropagationLossModel ()
+  : m_hits (0),
+    m_misses (0)
+{
+  m_inner = CreateObject<FriisPropagationLossModel> ();
+}
+
+CachedPropagationLossModel::~CachedPropagationLossModel ()
+{
+}
+
+void
+CachedPropagationLossModel::SetInner (Ptr<PropagationLossModel> inner)
+{
+  if (inner != 0)
+    {
+      m_inner = inner;
+    }
+}
+
+Ptr<PropagationLossModel>
+CachedPropagationLossModel::GetInner (void) const
+{
+  return m_inner;
+}
+
+uint64_t
+CachedPropagationLossModel::GetNHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+CachedPropagationLossModel::GetNMisses (void) const
+{
+  return m_misses;
+}
+
+uint32_t
+CachedPropagationLossModel::Watch (Ptr<MobilityModel> mobility) const
+{
+  Ptr<Node> node = mobility->GetObject<Node> ();
+  if (node == 0)
+    {
+      return NO_NODE;
+    }
+  uint32_t id = node->GetId ();
+  if (id >= m_watched.size ())
+    {
+      m_watched.resize (id + 1, false);
+    }
+  if (!m_watched[id])
+    {
+      m_watched[id] = true;
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&CachedPropagationLossModel::CourseChanged,
+                                                          const_cast<CachedPropagationLossModel *> (this)));
+    }
+  return id;
+}
+
+void
+CachedPropagationLossModel::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  Ptr<Node> node = mobility->GetObject<Node> ();
+  NS_LOG_LOGIC ("Node " << node->GetId () << " moved, dropping its cached losses");
+  m_cache.Invalidate (node->GetId ());
+}
+
+double
+CachedPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                           Ptr<MobilityModel> a,
+                                           Ptr<MobilityModel> b) const
+{
+  uint32_t tx = Watch (a);
+  uint32_t rx = Watch (b);
+  if (tx == NO_NODE || rx == NO_NODE)
+    {
+      return m_inner->CalcRxPower (txPowerDbm, a, b);
+    }
+
+  double loss;
+  if (m_cache.Lookup (tx, rx, loss))
+    {
+      m_hits++;
+      return txPowerDbm - loss;
+    }
+  m_misses++;
+  double rxPowerDbm = m_inner->CalcRxPower (txPowerDbm, a, b);
+  m_cache.Store (tx, rx, txPowerDbm - rxPowerDbm);
+  return rxPowerDbm;
+}
+
+int64_t
+CachedPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return m_inner->AssignStreams (stream);
+}
+
+TypeId
+CachedPropagationDelayModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedPropagationDelayModel")
+    .SetParent<PropagationDelayModel> ()
+    .AddConstructor<CachedPropagationDelayModel> ()
+    .AddAttribute ("Inner", "The deterministic delay model whose results are cached",
+                   PointerValue (),
+                   MakePointerAccessor (&CachedPropagationDelayModel::SetInner,
+                                        &CachedPropagationDelayModel::GetInner),
+                   MakePointerChecker<PropagationDelayModel> ())
+  ;
+  return tid;
+}
+
+CachedPropagationDelayModel::CachedPropagationDelayModel ()
+{
+  m_inner = CreateObject<ConstantSpeedPropagationDelayModel> ();
+}
+
+CachedPropagationDelayModel::~CachedPropagationDelayModel ()
+{
+}
+
+void
+CachedPropagationDelayModel::SetInner (Ptr<PropagationDelayModel> inner)
+{
+  if (inner != 0)
+    {
+      m_inner = inner;
+    }
+}
+
+Ptr<PropagationDelayModel>
+CachedPropagationDelayModel::GetInner (void) const
+{
+  return m_inner;
+}
+
+uint32_t
+CachedPropagationDelayModel::Watch (Ptr<MobilityModel> mobility) const
+{
+  Ptr<Node> node = mobility->GetObject<Node> ();
+  if (node == 0)
+    {
+      return NO_NODE;
+    }
+  uint32_t id = node->GetId ();
+  if (id >= m_watched.size ())
+    {
+      m_watched.resize (id + 1, false);
+    }
+  if (!m_watched[id])
+    {
+      m_watched[id] = true;
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&CachedPropagationDelayModel::CourseChanged,
+                                                          const_cast<CachedPropagationDelayModel *> (this)));
+    }
+  return id;
+}
+
+void
+CachedPropagationDelayModel::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  m_cache.Invalidate (mobility->GetObject<Node> ()->GetId ());
+}
+
+Time
+CachedPropagationDelayModel::GetDelay (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  uint32_t tx = Watch (a);
+  uint32_t rx = Watch (b);
+  if (tx == NO_NODE || rx == NO_NODE)
+    {
+      return m_inner->GetDelay (a, b);
+    }
+
+  int64_t steps;
+  if (m_cache.Lookup (tx, rx, steps))
+    {
+      return TimeStep (steps);
+    }
+  Time delay = m_inner->GetDelay (a, b);
+  m_cache.Store (tx, rx, delay.GetTimeStep ());
+  return delay;
+}
+
+int64_t
+CachedPropagationDelayModel::DoAssignStreams (int64_t stream)
+{
+  return m_inner->AssignStreams (stream);
+}
+
+} // namespace ns3
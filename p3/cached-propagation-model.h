@@ -0,0 +1,151 @@
+#ifndef CACHED_PROPAGATION_MODEL_H
+#define CACHED_PROPAGATION_MODEL_H
+
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/node-list.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * Dense (transmitter, receiver) table indexed by node id, with a valid
+ * bit per entry.  It is sized once, on the first Store, for the nodes that
+ * exist then (NodeList::GetNNodes ()); pairs involving a node created
+ * later are not cached.  Moving a node clears its row and column.  An
+ * entry takes sizeof (T) bytes and a bit: 9 MB for the 1000-node p3 runs,
+ * where every pair shares the channel.
+ */
+template <typename T>
+class PropagationPairCache
+{
+public:
+  PropagationPairCache () : m_nodes (0), m_sized (false) {}
+
+  bool Lookup (uint32_t tx, uint32_t rx, T &value) const
+  {
+    if (tx >= m_nodes || rx >= m_nodes || !m_valid[Index (tx, rx)])
+      {
+        return false;
+      }
+    value = m_values[Index (tx, rx)];
+    return true;
+  }
+
+  void Store (uint32_t tx, uint32_t rx, T value)
+  {
+    if (!m_sized)
+      {
+        m_sized = true;
+        m_nodes = NodeList::GetNNodes ();
+        m_values.assign (size_t (m_nodes) * m_nodes, T ());
+        m_valid.assign (size_t (m_nodes) * m_nodes, false);
+      }
+    if (tx >= m_nodes || rx >= m_nodes)
+      {
+        return;
+      }
+    m_values[Index (tx, rx)] = value;
+    m_valid[Index (tx, rx)] = true;
+  }
+
+  void Invalidate (uint32_t node)
+  {
+    if (node >= m_nodes)
+      {
+        return;
+      }
+    for (uint32_t i = 0; i < m_nodes; i++)
+      {
+        m_valid[Index (node, i)] = false;
+        m_valid[Index (i, node)] = false;
+      }
+  }
+
+private:
+  size_t Index (uint32_t tx, uint32_t rx) const
+  {
+    return size_t (tx) * m_nodes + rx;
+  }
+
+  uint32_t m_nodes;
+  bool m_sized;
+  std::vector<T> m_values;
+  std::vector<bool> m_valid;
+};
+
+/**
+ * Remembers the loss of an inner, deterministic loss model per node pair.
+ *
+ * The first evaluation of a pair stores txPowerDbm minus the inner
+ * result; later ones reuse it until either node's mobility model fires
+ * CourseChange.  Only models whose loss does not depend on the transmit
+ * power or on random draws (Friis, log distance ...) may be
+ * wrapped.  Mobility models that are not aggregated to a node are passed
+ * through uncached.
+ */
+class CachedPropagationLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CachedPropagationLossModel ();
+  virtual ~CachedPropagationLossModel ();
+
+  void SetInner (Ptr<PropagationLossModel> inner);
+  Ptr<PropagationLossModel> GetInner (void) const;
+
+  uint64_t GetNHits (void) const;
+  uint64_t GetNMisses (void) const;
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  uint32_t Watch (Ptr<MobilityModel> mobility) const;
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  Ptr<PropagationLossModel> m_inner;
+  mutable PropagationPairCache<double> m_cache;
+  mutable std::vector<bool> m_watched;   //!< node ids whose CourseChange is connected
+  mutable uint64_t m_hits;
+  mutable uint64_t m_misses;
+};
+
+/**
+ * Remembers the delay of an inner propagation delay model per node pair,
+ * under the same rules as CachedPropagationLossModel.
+ */
+class CachedPropagationDelayModel : public PropagationDelayModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CachedPropagationDelayModel ();
+  virtual ~CachedPropagationDelayModel ();
+
+  void SetInner (Ptr<PropagationDelayModel> inner);
+  Ptr<PropagationDelayModel> GetInner (void) const;
+
+  virtual Time GetDelay (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+
+private:
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  uint32_t Watch (Ptr<MobilityModel> mobility) const;
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  Ptr<PropagationDelayModel> m_inner;
+  mutable PropagationPairCache<int64_t> m_cache;
+  mutable std::vector<bool> m_watched;
+};
+
+} // namespace ns3
+
+#endif /* CACHED_PROPAGATION_MODEL_H */
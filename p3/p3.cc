@@ -32,8 +32,15 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-#define nMAXNODES	1000
+#include "../common/address-plan.h"
+#include "cached-propagation-model.h"
+#include "traffic-matrix.h"
+#include "../common/scale-probe.h"
 
 using namespace ns3;
 
@@ -45,6 +52,21 @@ void txPacketCounter ( ns3::Ptr<ns3::Packet const> a ) {
 	globalTxBytes += 256;
 }
 
+// "0.1,0.5,0.9" -> { 0.1, 0.5, 0.9 }; an empty list leaves values alone
+template <typename T>
+void parseList ( std::string list, std::vector<T> &values ) {
+	std::stringstream in (list);
+	std::string item;
+	while (std::getline (in, item, ',')) {
+		std::stringstream field (item);
+		T value;
+		if (!(field >> value)) {
+			NS_ABORT_MSG ("Cannot parse \"" << item << "\" in \"" << list << "\"");
+		}
+		values.push_back (value);
+	}
+}
+
 int main (int argc, char *argv[])
 {
 	
@@ -59,7 +81,18 @@ int main (int argc, char *argv[])
 	std::string 	phyMode ("DsssRate11Mbps");
 	std::string		udpDataRate = "1Mbps";
 	bool			verbose = 0;
+	bool			cacheLoss = false;
 	int 			count = 1;
+	std::string		traffic = "derangement";
+	uint32_t		hotspots = 1;
+	uint32_t		flowsPerNode = 2;
+	std::string		matrixIn = "";
+	std::string		matrixOut = "p3-matrix.txt";
+	bool			scaleReport = false;
+	double			branchTime = 0;
+	std::string		branchIntensity = "";
+	std::string		branchCount = "";
+	bool			crn = false;
 		
 	CommandLine cmd;	
 	cmd.AddValue ("nodeCount", "Number of wifi nodes", nodeCount);
@@ -68,10 +101,24 @@ int main (int argc, char *argv[])
 	cmd.AddValue ("routingProtocol", "Wifi routing protocol to use", protocol);
 	cmd.AddValue ("verbose", "Turn on module logging", verbose);
 	cmd.AddValue ("intensity","Traffic intensity on the network",intensity);
-	cmd.AddValue ("count","run counter",count);
+	cmd.AddValue ("count","run counter, selects the random stream of the traffic matrix",count);
+	cmd.AddValue ("traffic","Traffic matrix: derangement, nearest, hotspot, kflows or file", traffic);
+	cmd.AddValue ("hotspots","Number of destinations of --traffic=hotspot", hotspots);
+	cmd.AddValue ("flowsPerNode","Flows sent by every node with --traffic=kflows", flowsPerNode);
+	cmd.AddValue ("matrixIn","Traffic matrix to replay with --traffic=file", matrixIn);
+	cmd.AddValue ("matrixOut","File the traffic matrix of this run is written to (empty: none)", matrixOut);
+	cmd.AddValue ("cacheLoss","Cache loss and delay per node pair (nodes do not move)", cacheLoss);
 	
+	cmd.AddValue ("scaleReport","Print setup time, event rate and peak RSS (see common/scale-bench.sh)", scaleReport);
+	cmd.AddValue ("branchTime","Simulate the routing warm-up once up to this time (at most 10s), then fork one child per variant", branchTime);
+	cmd.AddValue ("branchIntensity","Comma-separated intensities to branch into (default: --intensity)", branchIntensity);
+	cmd.AddValue ("crn","Common random numbers: pin placement, wifi and traffic to fixed streams, so OLSR and AODV runs with the same --RngRun differ only in routing", crn);
+	cmd.AddValue ("branchCount","Comma-separated traffic matrix streams to branch into (default: --count)", branchCount);
 	cmd.Parse (argc, argv);
 	
+	ScaleProbe probe;
+	if (scaleReport) probe.Start ();
+	
 	if( verbose ) { LogComponentEnable ("P3", LOG_LEVEL_ALL); }
 	
 	if( nodeCount < 2 ) { nodeCount = 2; }
@@ -82,14 +129,21 @@ int main (int argc, char *argv[])
     }
 	
 	
-	udpRateInt = intensity * 11000;
-	std::stringstream temp;
-	temp << udpRateInt << "kbps";
-	udpDataRate = temp.str();
-	NS_LOG_INFO ("UDP data rate set to " << udpDataRate);
+	std::vector<double> intensities;
+	std::vector<int> counts;
+	parseList (branchIntensity, intensities);
+	parseList (branchCount, counts);
+	bool branch = branchTime > 0 || !intensities.empty () || !counts.empty ();
+	if (branch && (branchTime <= 0 || branchTime > 10)) {
+		NS_ABORT_MSG ("--branchTime must lie in (0, 10]: traffic starts at 10s");
+	}
+	if (intensities.empty ()) intensities.push_back (intensity);
+	if (counts.empty ()) counts.push_back (count);
+	for (uint32_t i = 0; i < counts.size (); ++i) {
+		NS_ABORT_MSG_IF (counts[i] < 0, "--count and --branchCount select a stream and must not be negative");
+	}
 	
 	Config::SetDefault ("ns3::OnOffApplication::PacketSize", UintegerValue (pktSize));
-	Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue (udpDataRate));
 	
 	// Convet mW to dbm
 	transPowerDbm = 10.0 * std::log10(transPower);
@@ -117,7 +171,15 @@ int main (int argc, char *argv[])
 	YansWifiChannelHelper wifiChannel;
 	wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
 	wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel");
-	wifiPhy.SetChannel (wifiChannel.Create ());
+	Ptr<YansWifiChannel> channel = wifiChannel.Create ();
+	
+	Ptr<CachedPropagationLossModel> cachedLoss;
+	if (cacheLoss) {
+		cachedLoss = CreateObject<CachedPropagationLossModel> ();
+		channel->SetPropagationLossModel (cachedLoss);
+		channel->SetPropagationDelayModel (CreateObject<CachedPropagationDelayModel> ());
+	}
+	wifiPhy.SetChannel (channel);
 
 	// Add a non-QoS upper mac, and disable rate control
 	NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
@@ -135,10 +197,20 @@ int main (int argc, char *argv[])
 	std::stringstream xyPos;
 	xyPos << "ns3::UniformRandomVariable[Min=0.0|Max=" << areaWidth << "]";
 		
-	mobility.SetPositionAllocator ("ns3::RandomRectanglePositionAllocator",
-									"X", StringValue (xyPos.str ()),
-									"Y", StringValue (xyPos.str ()));
+	Ptr<RandomRectanglePositionAllocator> positions = CreateObject<RandomRectanglePositionAllocator> ();
+	positions->SetAttribute ("X", StringValue (xyPos.str ()));
+	positions->SetAttribute ("Y", StringValue (xyPos.str ()));
+	mobility.SetPositionAllocator (positions);
 	mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+	
+	// Automatic stream numbers follow object creation order, which differs
+	// between OLSR and AODV.  With --crn everything but routing gets a fixed
+	// stream from 2^32 up, above every traffic matrix stream (--count, an int).
+	int64_t streamIndex = int64_t (1) << 32;
+	if (crn) {
+		streamIndex += positions->AssignStreams (streamIndex);
+		streamIndex += wifi.AssignStreams (devices, streamIndex);
+	}
 	mobility.Install (clientNodes);
 	
 
@@ -175,68 +247,129 @@ int main (int argc, char *argv[])
 	internet.SetRoutingHelper (list); // has effect on the next Install ()
 	internet.Install (clientNodes);
 	
-	Ipv4AddressHelper ipv4;
+	AddressPlan plan;
 	NS_LOG_INFO ("Assigning IP Addresses.");
-	ipv4.SetBase ("10.1.1.0", "255.255.255.0");
-	Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+	Ipv4InterfaceContainer interfaces = plan.AssignSubnet (devices);
 	
-	// Install on/off app on nodes
-	ApplicationContainer udpSourceApps[nMAXNODES];
-	
-	uint32_t *a=new uint32_t [nodeCount];          
-      
+	// Install UDP sink apps on nodes
+	ApplicationContainer udpSinkApps;
 	for(uint32_t i = 0; i < nodeCount; ++i) {
-		uint32_t randNode;
-		inHere : {
-			for(int i=0;i<count;i++){
-				randNode = rand () % nodeCount;
+		PacketSinkHelper sink ("ns3::UdpSocketFactory",
+							 InetSocketAddress (interfaces.GetAddress(i), 5001));
+		udpSinkApps.Add (sink.Install (clientNodes.Get (i)));
+	}
+	udpSinkApps.Start (Seconds (0.0));
+	udpSinkApps.Stop (Seconds (20));
+	
+	probe.SetupDone ();
+	
+	// Branching: nothing but routing traffic happens before 10s, so run that
+	// once and let every (intensity, count) variant continue from it in a
+	// forked child, sharing the warmed-up state copy-on-write.  The parent
+	// only waits; each child installs its sources and prints its own result.
+	if (branch) {
+		NS_LOG_INFO ("Warming up to " << branchTime << "s");
+		Simulator::Stop (Seconds (branchTime));
+		Simulator::Run ();
+		
+		std::vector<pid_t> children;
+		bool child = false;
+		for (uint32_t i = 0; i < intensities.size () * counts.size () && !child; ++i) {
+			std::cout.flush ();
+			pid_t pid = fork ();
+			NS_ABORT_MSG_IF (pid < 0, "fork failed");
+			if (pid == 0) {
+				child = true;
+				intensity = intensities[i / counts.size ()];
+				count = counts[i % counts.size ()];
+				// children would all write the same file
+				if (matrixOut != "") {
+					std::stringstream name;
+					name << matrixOut << "." << i;
+					matrixOut = name.str ();
+				}
+			} else {
+				children.push_back (pid);
 			}
 		}
-		uint32_t k=0;
-		while (k!=i && i!=0)
-		{
-			if(randNode == a[k] || randNode == i)
-				goto inHere;
-			k++;
+		if (!child) {
+			int failed = 0;
+			for (uint32_t i = 0; i < children.size (); ++i) {
+				int status;
+				if (waitpid (children[i], &status, 0) != children[i] || !WIFEXITED (status) || WEXITSTATUS (status) != 0) {
+					failed++;
+				}
+			}
+			Simulator::Destroy ();
+			if (failed) std::cerr << failed << " of " << children.size () << " branches failed" << std::endl;
+			return failed ? 1 : 0;
 		}
-		
-		a[i] = randNode;
-                        
+	}
+	
+	udpRateInt = intensity * 11000;
+	std::stringstream temp;
+	temp << udpRateInt << "kbps";
+	udpDataRate = temp.str();
+	NS_LOG_INFO ("UDP data rate set to " << udpDataRate);
+	Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue (udpDataRate));
+	
+	// Pick who talks to whom; the matrix has its own stream, so --count
+	// changes the pairs without moving the nodes
+	Ptr<TrafficMatrix> matrix = CreateObject<TrafficMatrix> ();
+	matrix->AssignStreams (count);
+	if (traffic == "derangement") {
+		matrix->Derangement (nodeCount);
+	} else if (traffic == "nearest") {
+		matrix->NearestNeighbour (clientNodes);
+	} else if (traffic == "hotspot") {
+		matrix->Hotspot (nodeCount, hotspots);
+	} else if (traffic == "kflows") {
+		matrix->KFlows (nodeCount, flowsPerNode);
+	} else if (traffic == "file") {
+		matrix->Load (matrixIn, nodeCount);
+	} else {
+		NS_ABORT_MSG ("Invalid traffic matrix: Use --traffic=derangement, nearest, hotspot, kflows or file");
+	}
+	if (matrixOut != "") {
+		matrix->Save (matrixOut);
+		NS_LOG_INFO ("Traffic matrix written to " << matrixOut << "; replay with --traffic=file --matrixIn=" << matrixOut);
+	}
+	
+	// Install on/off app on nodes
+	ApplicationContainer udpSourceApps;
+	const std::vector<TrafficMatrix::Flow> &flows = matrix->GetFlows ();
+	for(uint32_t i = 0; i < flows.size (); ++i) {
+		NS_LOG_LOGIC ("Flow " << flows[i].first << " -> " << flows[i].second);
 		OnOffHelper source ("ns3::UdpSocketFactory",
-								 InetSocketAddress (interfaces.GetAddress(randNode), 5001));
+								 InetSocketAddress (interfaces.GetAddress(flows[i].second), 5001));
 		source.SetAttribute ("OnTime", StringValue ("ns3::UniformRandomVariable[Min=0.1,Max=0.9]"));
 		source.SetAttribute ("OffTime", StringValue ("ns3::UniformRandomVariable[Min=0,Max=.1]"));
-		udpSourceApps[i] = source.Install (clientNodes.Get (i));
-		udpSourceApps[i].Start (Seconds(10));
-		udpSourceApps[i].Stop (Seconds (20));
+		udpSourceApps.Add (source.Install (clientNodes.Get (flows[i].first)));
 	}
-	
-	for(uint32_t i = 0; i < nodeCount; ++i) {
-		Ptr<Application>	app;
-		app = (udpSourceApps[i].Get(0));
-		app->TraceConnectWithoutContext ( "Tx", MakeCallback (&txPacketCounter));
+	// application start and stop times count from when they are installed
+	if (crn) {
+		for(uint32_t i = 0; i < udpSourceApps.GetN (); ++i) {
+			streamIndex += DynamicCast<OnOffApplication> (udpSourceApps.Get (i))->AssignStreams (streamIndex);
+		}
 	}
-
-	// Install UDP sink apps on nodes
-	ApplicationContainer udpSinkApps[nMAXNODES];
-	for(uint32_t i = 0; i < nodeCount; ++i) {
-		PacketSinkHelper sink ("ns3::UdpSocketFactory",
-							 InetSocketAddress (interfaces.GetAddress(i), 5001));
-		udpSinkApps[i] = sink.Install (clientNodes.Get (i));
-		udpSinkApps[i].Start (Seconds (0.0));
-		udpSinkApps[i].Stop (Seconds (20));
+	udpSourceApps.Start (Seconds(10) - Simulator::Now ());
+	udpSourceApps.Stop (Seconds (20) - Simulator::Now ());
+	
+	for(uint32_t i = 0; i < udpSourceApps.GetN (); ++i) {
+		udpSourceApps.Get (i)->TraceConnectWithoutContext ( "Tx", MakeCallback (&txPacketCounter));
 	}
 	
 	NS_LOG_INFO ("Running Simulator");
-	Simulator::Stop (Seconds (20));
+	Simulator::Stop (Seconds (20) - Simulator::Now ());
 	Simulator::Run ();
+	probe.RunDone ();
 	Simulator::Destroy ();
 	
 	double	rxBytes = 0;
 	double	totalRxBytes = 0;
 	Ptr<PacketSink> sink1;
 	for( uint32_t i = 0; i < nodeCount; ++i ) {
-		sink1 = DynamicCast<PacketSink> (udpSinkApps[i].Get(0));
+		sink1 = DynamicCast<PacketSink> (udpSinkApps.Get(i));
 		rxBytes = sink1->GetTotalRx ();
 		totalRxBytes += rxBytes;
 		if(verbose) std::cout << "node " << i << " total bytes: " << rxBytes << std::endl;
@@ -245,6 +378,10 @@ int main (int argc, char *argv[])
 	double	netEfficiency;
 	netEfficiency = totalRxBytes/globalTxBytes;
 	std::cout << "RP "<< protocol <<" N "<< nodeCount << " P "<< transPower << " I "<< intensity <<  " Efficiency " << netEfficiency << "count" << count << std::endl;
+	if (cachedLoss) {
+		std::cout << "Loss cache " << cachedLoss->GetNHits () << " hits, " << cachedLoss->GetNMisses () << " misses" << std::endl;
+	}
+	probe.Print (std::cout, "wifi");
 	
 	
 	NS_LOG_INFO ("Complete.");
@@ -0,0 +1,98 @@
+/*
+ * Micro-benchmark of the per-frame channel work of p3: for every
+ * transmitter, the loss and delay to every other node, as
+ * YansWifiChannel::Send computes them.  Compares Friis and constant speed
+ * delay with and without CachedPropagationLossModel / DelayModel at 100,
+ * 500 and 1000 static nodes.
+ *
+ * Link with cached-propagation-model.cc.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+#include "cached-propagation-model.h"
+
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("PropagationBench");
+
+static double
+WallSeconds (void)
+{
+	struct timeval tv;
+	gettimeofday (&tv, 0);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// one "frame" per node: the fan-out of a transmission to every receiver
+static double
+RunFrames (std::vector<Ptr<MobilityModel> > &mobility, Ptr<PropagationLossModel> loss,
+		Ptr<PropagationDelayModel> delay, uint32_t rounds, double &checksum)
+{
+	double start = WallSeconds ();
+	for (uint32_t r = 0; r < rounds; r++) {
+		for (uint32_t tx = 0; tx < mobility.size (); tx++) {
+			for (uint32_t rx = 0; rx < mobility.size (); rx++) {
+				if (rx == tx) continue;
+				checksum += loss->CalcRxPower (20.0, mobility[tx], mobility[rx]);
+				checksum += delay->GetDelay (mobility[tx], mobility[rx]).GetSeconds ();
+			}
+		}
+	}
+	return WallSeconds () - start;
+}
+
+int main (int argc, char *argv[])
+{
+	uint32_t	rounds = 10;
+	uint32_t	areaWidth = 1000;
+
+	CommandLine cmd;
+	cmd.AddValue ("rounds", "Frames sent by every node per measurement", rounds);
+	cmd.AddValue ("areaWidth", "Width of square area in meters", areaWidth);
+	cmd.Parse (argc, argv);
+
+	uint32_t sizes[] = { 100, 500, 1000 };
+	for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++) {
+		NodeContainer nodes;
+		nodes.Create (sizes[s]);
+
+		std::stringstream xyPos;
+		xyPos << "ns3::UniformRandomVariable[Min=0.0|Max=" << areaWidth << "]";
+		MobilityHelper mobilityHelper;
+		mobilityHelper.SetPositionAllocator ("ns3::RandomRectanglePositionAllocator",
+										"X", StringValue (xyPos.str ()),
+										"Y", StringValue (xyPos.str ()));
+		mobilityHelper.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+		mobilityHelper.Install (nodes);
+
+		std::vector<Ptr<MobilityModel> > mobility;
+		for (uint32_t i = 0; i < nodes.GetN (); i++) {
+			mobility.push_back (nodes.Get (i)->GetObject<MobilityModel> ());
+		}
+
+		double plainSum = 0;
+		double cachedSum = 0;
+		double plain = RunFrames (mobility, CreateObject<FriisPropagationLossModel> (),
+						CreateObject<ConstantSpeedPropagationDelayModel> (), rounds, plainSum);
+		double cached = RunFrames (mobility, CreateObject<CachedPropagationLossModel> (),
+						CreateObject<CachedPropagationDelayModel> (), rounds, cachedSum);
+
+		double receptions = double (rounds) * sizes[s] * (sizes[s] - 1);
+		std::cout << "nodes " << sizes[s]
+				<< " uncached " << receptions / plain << " rx/s"
+				<< " cached " << receptions / cached << " rx/s"
+				<< " speedup " << plain / cached
+				<< " checksum diff " << plainSum - cachedSum << std::endl;
+	}
+
+	Simulator::Destroy ();
+	return 0;
+}
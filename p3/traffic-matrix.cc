@@ -0,0 +1,307 @@
+#include "traffic-matrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/mobility-model.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TrafficMatrix");
+
+NS_OBJECT_ENSURE_REGISTERED (TrafficMatrix);
+
+TypeId
+TrafficMatrix::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TrafficMatrix")
+    .SetParent<Object> ()
+    .AddConstructor<TrafficMatrix> ()
+  ;
+  return tid;
+}
+
+TrafficMatrix::TrafficMatrix ()
+{
+  NS_LOG_FUNCTION (this);
+  m_rng = CreateObject<UniformRandomVariable> ();
+}
+
+TrafficMatrix::~TrafficMatrix ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TrafficMatrix::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rng = 0;
+  Object::DoDispose ();
+}
+
+int64_t
+TrafficMatrix::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rng->SetStream (stream);
+  return 1;
+}
+
+void
+TrafficMatrix::Derangement (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ABORT_MSG_IF (n < 2, "A derangement needs at least two nodes");
+
+  // Fisher-Yates from the back, restarting as soon as a position keeps its
+  // own index; about e attempts are needed on average
+  std::vector<uint32_t> destination (n);
+  bool fixedPoint;
+  do
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          destination[i] = i;
+        }
+      fixedPoint = false;
+      for (uint32_t i = n - 1; i > 0 && !fixedPoint; i--)
+        {
+          std::swap (destination[i], destination[m_rng->GetInteger (0, i)]);
+          fixedPoint = destination[i] == i;
+        }
+      fixedPoint = fixedPoint || destination[0] == 0;
+    }
+  while (fixedPoint);
+
+  m_flows.clear ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_flows.push_back (Flow (i, destination[i]));
+    }
+}
+
+void
+TrafficMatrix::NearestNeighbour (NodeContainer nodes)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t n = nodes.GetN ();
+  NS_ABORT_MSG_IF (n < 2, "Nearest neighbour traffic needs at least two nodes");
+
+  std::vector<Vector> position (n);
+  double minX = 0, maxX = 0, minY = 0, maxY = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<MobilityModel> mobility = nodes.Get (i)->GetObject<MobilityModel> ();
+      NS_ABORT_MSG_IF (mobility == 0, "Node " << i << " has no mobility model");
+      position[i] = mobility->GetPosition ();
+      if (i == 0 || position[i].x < minX) minX = position[i].x;
+      if (i == 0 || position[i].x > maxX) maxX = position[i].x;
+      if (i == 0 || position[i].y < minY) minY = position[i].y;
+      if (i == 0 || position[i].y > maxY) maxY = position[i].y;
+    }
+
+  // about one node per cell of a side x side grid, bucketed by counting sort
+  uint32_t side = std::max<uint32_t> (1, static_cast<uint32_t> (std::sqrt (double (n))));
+  double cellX = (maxX - minX) / side + 1e-9;
+  double cellY = (maxY - minY) / side + 1e-9;
+  std::vector<uint32_t> cellOf (n);
+  std::vector<uint32_t> cellStart (side * side + 1, 0);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t cx = std::min<uint32_t> (side - 1, static_cast<uint32_t> ((position[i].x - minX) / cellX));
+      uint32_t cy = std::min<uint32_t> (side - 1, static_cast<uint32_t> ((position[i].y - minY) / cellY));
+      cellOf[i] = cy * side + cx;
+      cellStart[cellOf[i] + 1]++;
+    }
+  for (uint32_t c = 0; c < side * side; c++)
+    {
+      cellStart[c + 1] += cellStart[c];
+    }
+  std::vector<uint32_t> members (n);
+  std::vector<uint32_t> fill (cellStart.begin (), cellStart.end () - 1);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      members[fill[cellOf[i]]++] = i;
+    }
+
+  double ringWidth = std::min (cellX, cellY);
+  m_flows.clear ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      int32_t cx = cellOf[i] % side;
+      int32_t cy = cellOf[i] / side;
+      uint32_t best = i;
+      double bestDistance = 0;
+      // a node on ring r or beyond can be as close as r - 1 cell widths,
+      // just across the border of the cell next to ours; stop when the
+      // best so far is strictly closer, so a tie on a later ring still
+      // goes to the lower index
+      for (int32_t r = 0; r <= int32_t (side); r++)
+        {
+          double bound = (r - 1) * ringWidth;
+          if (best != i && r >= 1 && bestDistance < bound * bound)
+            {
+              break;
+            }
+          for (int32_t y = cy - r; y <= cy + r; y++)
+            {
+              for (int32_t x = cx - r; x <= cx + r; x++)
+                {
+                  bool onRing = x == cx - r || x == cx + r || y == cy - r || y == cy + r;
+                  if (!onRing || x < 0 || y < 0 || x >= int32_t (side) || y >= int32_t (side))
+                    {
+                      continue;
+                    }
+                  uint32_t c = y * side + x;
+                  for (uint32_t m = cellStart[c]; m < cellStart[c + 1]; m++)
+                    {
+                      uint32_t j = members[m];
+                      if (j == i)
+                        {
+                          continue;
+                        }
+                      double dx = position[i].x - position[j].x;
+                      double dy = position[i].y - position[j].y;
+                      double dz = position[i].z - position[j].z;
+                      double distance = dx * dx + dy * dy + dz * dz;
+                      if (best == i || distance < bestDistance || (distance == bestDistance && j < best))
+                        {
+                          best = j;
+                          bestDistance = distance;
+                        }
+                    }
+                }
+            }
+        }
+      m_flows.push_back (Flow (i, best));
+    }
+}
+
+void
+TrafficMatrix::Hotspot (uint32_t n, uint32_t hotspots)
+{
+  NS_LOG_FUNCTION (this << n << hotspots);
+  NS_ABORT_MSG_IF (n < 2, "Hotspot traffic needs at least two nodes");
+  NS_ABORT_MSG_IF (hotspots == 0 || hotspots > n, "Need between 1 and " << n << " hotspots");
+
+  // the first hotspots entries of a partial shuffle
+  std::vector<uint32_t> order (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      order[i] = i;
+    }
+  for (uint32_t i = 0; i < hotspots; i++)
+    {
+      std::swap (order[i], order[m_rng->GetInteger (i, n - 1)]);
+    }
+  std::vector<bool> isHotspot (n, false);
+  for (uint32_t i = 0; i < hotspots; i++)
+    {
+      isHotspot[order[i]] = true;
+    }
+
+  m_flows.clear ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t destination;
+      if (!isHotspot[i])
+        {
+          destination = order[m_rng->GetInteger (0, hotspots - 1)];
+        }
+      else if (hotspots > 1)
+        {
+          do
+            {
+              destination = order[m_rng->GetInteger (0, hotspots - 1)];
+            }
+          while (destination == i);
+        }
+      else
+        {
+          // any other node: draw from n - 1 and skip over ourselves
+          destination = m_rng->GetInteger (0, n - 2);
+          destination += destination >= i ? 1 : 0;
+        }
+      m_flows.push_back (Flow (i, destination));
+    }
+}
+
+void
+TrafficMatrix::KFlows (uint32_t n, uint32_t k)
+{
+  NS_LOG_FUNCTION (this << n << k);
+  NS_ABORT_MSG_IF (k == 0 || k >= n, "Need between 1 and " << n - 1 << " flows per node");
+
+  m_flows.clear ();
+  std::vector<uint32_t> chosen;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      chosen.clear ();
+      while (chosen.size () < k)
+        {
+          uint32_t destination = m_rng->GetInteger (0, n - 2);
+          destination += destination >= i ? 1 : 0;
+          if (std::find (chosen.begin (), chosen.end (), destination) == chosen.end ())
+            {
+              chosen.push_back (destination);
+              m_flows.push_back (Flow (i, destination));
+            }
+        }
+    }
+}
+
+void
+TrafficMatrix::Load (std::string filename, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << filename << n);
+  std::ifstream in (filename.c_str ());
+  NS_ABORT_MSG_IF (!in, "Cannot open traffic matrix " << filename);
+
+  m_flows.clear ();
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (std::getline (in, line))
+    {
+      lineNumber++;
+      std::istringstream fields (line);
+      uint32_t source;
+      uint32_t destination;
+      if (line.empty () || line[0] == '#' || !(fields >> source))
+        {
+          continue;
+        }
+      NS_ABORT_MSG_IF (!(fields >> destination), filename << ":" << lineNumber << ": expected \"source destination\"");
+      NS_ABORT_MSG_IF (source >= n || destination >= n || source == destination,
+                       filename << ":" << lineNumber << ": invalid flow " << source << " -> " << destination);
+      m_flows.push_back (Flow (source, destination));
+    }
+}
+
+void
+TrafficMatrix::Save (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ofstream out (filename.c_str ());
+  NS_ABORT_MSG_IF (!out, "Cannot write traffic matrix " << filename);
+  out << "# source destination" << std::endl;
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      out << m_flows[i].first << " " << m_flows[i].second << "\n";
+    }
+}
+
+const std::vector<TrafficMatrix::Flow> &
+TrafficMatrix::GetFlows (void) const
+{
+  return m_flows;
+}
+
+} // namespace ns3
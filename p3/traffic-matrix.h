@@ -0,0 +1,81 @@
+#ifndef TRAFFIC_MATRIX_H
+#define TRAFFIC_MATRIX_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * Source/destination pairs of the flows of a run, as indices into the
+ * scenario's node container.
+ *
+ * Every random pattern draws from one UniformRandomVariable, so a matrix
+ * is fixed by --RngSeed, --RngRun and the stream given to AssignStreams,
+ * on any machine.  Save () writes one "source destination" line per flow
+ * in the format Load () reads, so a run can be replayed exactly.
+ */
+class TrafficMatrix : public Object
+{
+public:
+  typedef std::pair<uint32_t, uint32_t> Flow;  //!< (source, destination)
+
+  static TypeId GetTypeId (void);
+
+  TrafficMatrix ();
+  virtual ~TrafficMatrix ();
+
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * Uniformly random derangement: every node sends one flow and receives
+   * one, never from itself.  Expected O(n).
+   */
+  void Derangement (uint32_t n);
+
+  /**
+   * Every node sends to the closest other node, by position of their
+   * mobility models; ties go to the lower index.  Near O(n) for nodes
+   * spread over an area.
+   */
+  void NearestNeighbour (NodeContainer nodes);
+
+  /**
+   * Every node sends to one of hotspots randomly chosen nodes; a hotspot
+   * sends to another hotspot, or to a random node if it is the only one.
+   */
+  void Hotspot (uint32_t n, uint32_t hotspots);
+
+  /**
+   * Every node sends k flows to k distinct random other nodes.
+   */
+  void KFlows (uint32_t n, uint32_t k);
+
+  /**
+   * Read "source destination" lines; blank lines and lines starting with
+   * '#' are skipped.  Aborts on indices outside [0, n) or self flows.
+   */
+  void Load (std::string filename, uint32_t n);
+
+  void Save (std::string filename) const;
+
+  const std::vector<Flow> & GetFlows (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  Ptr<UniformRandomVariable> m_rng;
+  std::vector<Flow> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* TRAFFIC_MATRIX_H */
@@ -0,0 +1,212 @@
+#include "dumbbell-topology-helper.h"
+#include "../common/address-plan.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/constant-position-mobility-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DumbbellTopologyHelper");
+
+DumbbellTopologyHelper::DumbbellTopologyHelper (uint32_t nLeftLeaf, PointToPointHelper leftHelper,
+                                                uint32_t nRightLeaf, PointToPointHelper rightHelper,
+                                                PointToPointHelper bottleneckHelper, uint32_t systems)
+{
+  NS_ABORT_MSG_IF (systems == 0, "A dumbbell needs at least one system");
+  // leaf j of the left leaves followed by the right ones goes to system
+  // j * systems / leaves; each router joins its first leaf
+  uint64_t leaves = std::max<uint64_t> (uint64_t (nLeftLeaf) + nRightLeaf, 1);
+  uint32_t rightSystem = std::min<uint64_t> (nLeftLeaf * uint64_t (systems) / leaves, systems - 1);
+
+  m_routers.Add (CreateObject<Node> (0));
+  m_routers.Add (CreateObject<Node> (rightSystem));
+  for (uint32_t i = 0; i < nLeftLeaf; ++i)
+    {
+      m_leftLeaf.Add (CreateObject<Node> (uint64_t (i) * systems / leaves));
+    }
+  for (uint32_t i = 0; i < nRightLeaf; ++i)
+    {
+      m_rightLeaf.Add (CreateObject<Node> ((nLeftLeaf + uint64_t (i)) * systems / leaves));
+    }
+  NS_LOG_INFO ("Dumbbell of " << nLeftLeaf << " + " << nRightLeaf << " leaves over " << systems << " systems");
+
+  m_routerDevices = bottleneckHelper.Install (m_routers);
+  for (uint32_t i = 0; i < nLeftLeaf; ++i)
+    {
+      NetDeviceContainer c = leftHelper.Install (m_routers.Get (0), m_leftLeaf.Get (i));
+      m_leftRouterDevices.Add (c.Get (0));
+      m_leftLeafDevices.Add (c.Get (1));
+    }
+  for (uint32_t i = 0; i < nRightLeaf; ++i)
+    {
+      NetDeviceContainer c = rightHelper.Install (m_routers.Get (1), m_rightLeaf.Get (i));
+      m_rightRouterDevices.Add (c.Get (0));
+      m_rightLeafDevices.Add (c.Get (1));
+    }
+}
+
+DumbbellTopologyHelper::~DumbbellTopologyHelper ()
+{
+}
+
+Ptr<Node>
+DumbbellTopologyHelper::GetLeft (void) const
+{
+  return m_routers.Get (0);
+}
+
+Ptr<Node>
+DumbbellTopologyHelper::GetLeft (uint32_t i) const
+{
+  return m_leftLeaf.Get (i);
+}
+
+Ptr<Node>
+DumbbellTopologyHelper::GetRight (void) const
+{
+  return m_routers.Get (1);
+}
+
+Ptr<Node>
+DumbbellTopologyHelper::GetRight (uint32_t i) const
+{
+  return m_rightLeaf.Get (i);
+}
+
+Ipv4Address
+DumbbellTopologyHelper::GetLeftIpv4Address (uint32_t i) const
+{
+  return m_leftLeafInterfaces.GetAddress (i);
+}
+
+Ipv4Address
+DumbbellTopologyHelper::GetRightIpv4Address (uint32_t i) const
+{
+  return m_rightLeafInterfaces.GetAddress (i);
+}
+
+uint32_t
+DumbbellTopologyHelper::LeftCount (void) const
+{
+  return m_leftLeaf.GetN ();
+}
+
+uint32_t
+DumbbellTopologyHelper::RightCount (void) const
+{
+  return m_rightLeaf.GetN ();
+}
+
+void
+DumbbellTopologyHelper::InstallStack (InternetStackHelper stack)
+{
+  stack.Install (m_routers);
+  stack.Install (m_leftLeaf);
+  stack.Install (m_rightLeaf);
+}
+
+void
+DumbbellTopologyHelper::AssignIpv4Addresses (Ipv4AddressHelper leftIp, Ipv4AddressHelper rightIp,
+                                             Ipv4AddressHelper routerIp)
+{
+  m_routerInterfaces = routerIp.Assign (m_routerDevices);
+  for (uint32_t i = 0; i < LeftCount (); ++i)
+    {
+      NetDeviceContainer pair;
+      pair.Add (m_leftLeafDevices.Get (i));
+      pair.Add (m_leftRouterDevices.Get (i));
+      Ipv4InterfaceContainer interfaces = leftIp.Assign (pair);
+      m_leftLeafInterfaces.Add (interfaces.Get (0));
+      m_leftRouterInterfaces.Add (interfaces.Get (1));
+      leftIp.NewNetwork ();
+    }
+  for (uint32_t i = 0; i < RightCount (); ++i)
+    {
+      NetDeviceContainer pair;
+      pair.Add (m_rightLeafDevices.Get (i));
+      pair.Add (m_rightRouterDevices.Get (i));
+      Ipv4InterfaceContainer interfaces = rightIp.Assign (pair);
+      m_rightLeafInterfaces.Add (interfaces.Get (0));
+      m_rightRouterInterfaces.Add (interfaces.Get (1));
+      rightIp.NewNetwork ();
+    }
+}
+
+void
+DumbbellTopologyHelper::AssignIpv4Addresses (AddressPlan &plan)
+{
+  m_routerInterfaces = plan.AssignPointToPoint (m_routerDevices);
+  for (uint32_t i = 0; i < LeftCount (); ++i)
+    {
+      NetDeviceContainer pair;
+      pair.Add (m_leftLeafDevices.Get (i));
+      pair.Add (m_leftRouterDevices.Get (i));
+      Ipv4InterfaceContainer interfaces = plan.AssignPointToPoint (pair);
+      m_leftLeafInterfaces.Add (interfaces.Get (0));
+      m_leftRouterInterfaces.Add (interfaces.Get (1));
+    }
+  for (uint32_t i = 0; i < RightCount (); ++i)
+    {
+      NetDeviceContainer pair;
+      pair.Add (m_rightLeafDevices.Get (i));
+      pair.Add (m_rightRouterDevices.Get (i));
+      Ipv4InterfaceContainer interfaces = plan.AssignPointToPoint (pair);
+      m_rightLeafInterfaces.Add (interfaces.Get (0));
+      m_rightRouterInterfaces.Add (interfaces.Get (1));
+    }
+}
+
+namespace {
+
+void
+Place (Ptr<Node> node, double x, double y)
+{
+  Ptr<ConstantPositionMobilityModel> loc = node->GetObject<ConstantPositionMobilityModel> ();
+  if (loc == 0)
+    {
+      loc = CreateObject<ConstantPositionMobilityModel> ();
+      node->AggregateObject (loc);
+    }
+  loc->SetPosition (Vector (x, y, 0));
+}
+
+} // anonymous namespace
+
+void
+DumbbellTopologyHelper::BoundingBox (double ulx, double uly, double lrx, double lry)
+{
+  double xDist = std::fabs (lrx - ulx);
+  double yDist = std::fabs (lry - uly);
+  double xAdder = xDist / 3.0;
+  double ry = uly + yDist / 2.0;
+  Place (GetLeft (), ulx + xAdder, ry);
+  Place (GetRight (), ulx + xAdder * 2, ry);
+
+  // leaves on a half circle around their router, the middle one level with it
+  for (uint32_t side = 0; side < 2; side++)
+    {
+      uint32_t n = side == 0 ? LeftCount () : RightCount ();
+      double step = M_PI / (n + 1.0);
+      double theta = -M_PI_2 + step;
+      double x = side == 0 ? ulx + xAdder : ulx + xAdder * 2;
+      double direction = side == 0 ? -1 : 1;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          if (n % 2 == 1 && i == n / 2)
+            {
+              theta = 0.0;
+            }
+          double y = std::min (std::max (ry + std::sin (theta) * xAdder, uly), lry);
+          Place (side == 0 ? GetLeft (i) : GetRight (i), x + direction * std::cos (theta) * xAdder, y);
+          theta += step;
+        }
+    }
+}
+
+} // namespace ns3
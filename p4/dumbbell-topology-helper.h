@@ -0,0 +1,85 @@
+#ifndef DUMBBELL_TOPOLOGY_HELPER_H
+#define DUMBBELL_TOPOLOGY_HELPER_H
+
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/point-to-point-helper.h"
+
+namespace ns3 {
+
+class AddressPlan;
+
+/**
+ * PointToPointDumbbellHelper whose nodes can be spread over several
+ * systems (MPI ranks) for the distributed simulator.
+ *
+ * The layout, the node and device order, the addresses and the positions
+ * are those of PointToPointDumbbellHelper, which can only create its nodes
+ * on system 0.  With more than one system the left leaves followed by the
+ * right leaves are split into equal contiguous blocks over all systems,
+ * and each router goes to the system of its first leaf: with two systems
+ * and equal sides each side gets its own system, past that a system may
+ * hold leaves of both sides.  The bottleneck and the access links whose
+ * leaf is on another system than its router cross ranks, and their delays
+ * become the lookahead.
+ */
+class DumbbellTopologyHelper
+{
+public:
+  DumbbellTopologyHelper (uint32_t nLeftLeaf, PointToPointHelper leftHelper,
+                          uint32_t nRightLeaf, PointToPointHelper rightHelper,
+                          PointToPointHelper bottleneckHelper, uint32_t systems = 1);
+
+  ~DumbbellTopologyHelper ();
+
+  Ptr<Node> GetLeft (void) const;
+  Ptr<Node> GetLeft (uint32_t i) const;
+  Ptr<Node> GetRight (void) const;
+  Ptr<Node> GetRight (uint32_t i) const;
+
+  Ipv4Address GetLeftIpv4Address (uint32_t i) const;
+  Ipv4Address GetRightIpv4Address (uint32_t i) const;
+
+  uint32_t LeftCount (void) const;
+  uint32_t RightCount (void) const;
+
+  void InstallStack (InternetStackHelper stack);
+
+  /**
+   * Same assignment as PointToPointDumbbellHelper: one network per leaf
+   * link, the leaf first, and the router link from routerIp.
+   */
+  void AssignIpv4Addresses (Ipv4AddressHelper leftIp, Ipv4AddressHelper rightIp, Ipv4AddressHelper routerIp);
+
+  /**
+   * Give every link its own /30 from the plan: the router link first (left
+   * router on the first address), then the left leaf links and then the
+   * right ones, leaf on the first address.  Right leaf i thus sits in
+   * block 1 + LeftCount () + i.
+   */
+  void AssignIpv4Addresses (AddressPlan &plan);
+
+  void BoundingBox (double ulx, double uly, double lrx, double lry);
+
+private:
+  NodeContainer m_leftLeaf;
+  NetDeviceContainer m_leftLeafDevices;
+  NodeContainer m_rightLeaf;
+  NetDeviceContainer m_rightLeafDevices;
+  NodeContainer m_routers;
+  NetDeviceContainer m_routerDevices;
+  NetDeviceContainer m_leftRouterDevices;
+  NetDeviceContainer m_rightRouterDevices;
+  Ipv4InterfaceContainer m_leftLeafInterfaces;
+  Ipv4InterfaceContainer m_leftRouterInterfaces;
+  Ipv4InterfaceContainer m_rightLeafInterfaces;
+  Ipv4InterfaceContainer m_rightRouterInterfaces;
+  Ipv4InterfaceContainer m_routerInterfaces;
+};
+
+} // namespace ns3
+
+#endif /* DUMBBELL_TOPOLOGY_HELPER_H */
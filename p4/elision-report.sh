@@ -0,0 +1,59 @@
+#!/bin/sh
+# Scan-miss elision report: runs star, barbell and tree once sending every
+# worm scan and once with --elideMisses, and prints the executed events of
+# both runs, their ratio, the elided scans and how far the infection curves
+# drift apart (the k-th infection time of one run against the other's).
+#
+# Run from the ns-3 tree the scenarios are built in:
+#   WAF=./waf sh p4/elision-report.sh > elision.tsv
+# TOPOLOGIES and the *_ARGS variables override the scenarios.  The curves
+# only match where a missed train never shared a queue with a hit, so the
+# drift column is the price of the speedup on that topology.
+
+WAF=${WAF:-./waf}
+TOPOLOGIES=${TOPOLOGIES:-"star barbell tree"}
+STAR_ARGS=${STAR_ARGS:-"--nNodes=50"}
+BARBELL_ARGS=${BARBELL_ARGS:-"--nNodes=50"}
+TREE_ARGS=${TREE_ARGS:-"--depth=3 --fanout=5 --rootFanout=4"}
+
+full=$(mktemp)
+elided=$(mktemp)
+curves=$(mktemp)
+trap 'rm -f $full $elided $curves $curves.elided' EXIT
+
+# infection times in order: star and tree print "Node i infected at Ts by ...",
+# the barbell prints the bare time
+curve ()
+{
+	awk '$3 == "infected" && $4 == "at" { sub (/s$/, "", $5); print $5 }
+		/^[0-9.e+-]+$/ { print $1 }' $1 | sort -g
+}
+
+# Scale <topology> nodes N setup Xs run Ys events E rate R/s peakRss K KiB
+field ()
+{
+	awk -v k=$2 '$1 == "Scale" { sub (/s$/, "", $k); print $k }' $1
+}
+
+printf "topology\tevents\telided_events\tratio\trun_s\telided_run_s\tinfected\telided_infected\telided_scans\tmax_drift_s\tmean_drift_s\n"
+for topology in $TOPOLOGIES; do
+	case $topology in
+		star) args="p4_star $STAR_ARGS" ;;
+		barbell) args="p4_barbell $BARBELL_ARGS" ;;
+		tree) args="p4_tree $TREE_ARGS" ;;
+		*) echo "unknown topology $topology" >&2; exit 1 ;;
+	esac
+	$WAF --run "$args --scaleReport=true" > $full 2>/dev/null
+	$WAF --run "$args --scaleReport=true --elideMisses=true" > $elided 2>/dev/null
+	scans=$(awk '$1 == "Elided" { print $2 }' $elided)
+	curve $elided > $curves.elided
+	drift=$(curve $full | paste - $curves.elided |
+		awk -F '\t' '$1 != "" && $2 != "" { d = $1 - $2; if (d < 0) d = -d; if (d > max) max = d; sum += d; n++ }
+			END { printf "%g\t%g", max, n ? sum / n : 0 }')
+	printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n" $topology \
+		$(field $full 10) $(field $elided 10) \
+		$(awk -v a=$(field $full 10) -v b=$(field $elided 10) 'BEGIN { printf "%.2f", (b > 0 ? a / b : 0) }') \
+		$(field $full 8) $(field $elided 8) \
+		$(awk '/nodes infected/ { print $1 }' $full) $(awk '/nodes infected/ { print $1 }' $elided) \
+		${scans:-0} "$drift"
+done
@@ -0,0 +1,287 @@
+#include "infection-registry.h"
+#include "worm.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4.h"
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("InfectionRegistry");
+
+NS_OBJECT_ENSURE_REGISTERED (InfectionRegistry);
+
+const uint32_t InfectionRegistry::NO_INFECTOR;
+
+#ifdef NS3_MPI
+namespace {
+
+bool
+RecordTimeLess (const InfectionRecord &a, const InfectionRecord &b)
+{
+  return a.time < b.time;
+}
+
+} // anonymous namespace
+#endif
+
+TypeId
+InfectionRegistry::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::InfectionRegistry")
+    .SetParent<Object> ()
+    .AddConstructor<InfectionRegistry> ()
+  ;
+  return tid;
+}
+
+InfectionRegistry::InfectionRegistry ()
+  : m_addressesSorted (true),
+    m_population (0),
+    m_count (0),
+    m_stopWhenAll (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+InfectionRegistry::~InfectionRegistry ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+InfectionRegistry::Track (Ptr<WormApplication> app)
+{
+  NS_LOG_FUNCTION (this << app);
+  AddHost (app->GetNode ());
+  app->TraceConnectWithoutContext ("Infection", MakeCallback (&InfectionRegistry::NotifyInfection, this));
+}
+
+void
+InfectionRegistry::AddHost (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  uint32_t nodeId = node->GetId ();
+
+  if (nodeId >= m_recordIndex.size ())
+    {
+      m_recordIndex.resize (nodeId + 1, NO_INFECTOR);
+      m_infected.resize (nodeId / 64 + 1, 0);
+    }
+
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  if (ipv4 != 0)
+    {
+      for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+        {
+          for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+            {
+              Ipv4Address address = ipv4->GetAddress (i, j).GetLocal ();
+              if (address != Ipv4Address::GetLoopback ())
+                {
+                  AddAddress (address, nodeId);
+                }
+            }
+        }
+    }
+
+  m_population++;
+}
+
+void
+InfectionRegistry::Merge (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef NS3_MPI
+  int initialized;
+  MPI_Initialized (&initialized);
+  if (!initialized)
+    {
+      return;
+    }
+  int size;
+  MPI_Comm_size (MPI_COMM_WORLD, &size);
+  if (size == 1)
+    {
+      return;
+    }
+
+  // (node, infector, time in time steps) per record
+  std::vector<int64_t> local;
+  for (uint32_t i = 0; i < m_records.size (); i++)
+    {
+      local.push_back (m_records[i].nodeId);
+      local.push_back (m_records[i].infectorId);
+      local.push_back (m_records[i].time.GetTimeStep ());
+    }
+  int count = local.size ();
+  std::vector<int> counts (size);
+  MPI_Allgather (&count, 1, MPI_INT, &counts[0], 1, MPI_INT, MPI_COMM_WORLD);
+  std::vector<int> offsets (size, 0);
+  for (int r = 1; r < size; r++)
+    {
+      offsets[r] = offsets[r - 1] + counts[r - 1];
+    }
+  std::vector<int64_t> all (offsets[size - 1] + counts[size - 1] + 1);
+  MPI_Allgatherv (local.empty () ? 0 : &local[0], count, MPI_LONG_LONG,
+                  &all[0], &counts[0], &offsets[0], MPI_LONG_LONG, MPI_COMM_WORLD);
+
+  std::vector<InfectionRecord> records;
+  for (size_t i = 0; i + 2 < all.size (); i += 3)
+    {
+      InfectionRecord record;
+      record.nodeId = all[i];
+      record.infectorId = all[i + 1];
+      record.time = TimeStep (all[i + 2]);
+      records.push_back (record);
+    }
+  std::stable_sort (records.begin (), records.end (), RecordTimeLess);
+
+  std::fill (m_infected.begin (), m_infected.end (), 0);
+  std::fill (m_recordIndex.begin (), m_recordIndex.end (), NO_INFECTOR);
+  m_records.clear ();
+  m_count = 0;
+  for (size_t i = 0; i < records.size (); i++)
+    {
+      if (records[i].nodeId < m_recordIndex.size () && !IsInfected (records[i].nodeId))
+        {
+          AddRecord (records[i]);
+        }
+    }
+#endif
+}
+
+void
+InfectionRegistry::StopWhenAllInfected (Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_stopWhenAll = true;
+  m_stopDelay = delay;
+}
+
+uint32_t
+InfectionRegistry::GetPopulation (void) const
+{
+  return m_population;
+}
+
+uint32_t
+InfectionRegistry::GetInfectedCount (void) const
+{
+  return m_count;
+}
+
+bool
+InfectionRegistry::IsInfected (uint32_t nodeId) const
+{
+  if (nodeId >= m_recordIndex.size ())
+    {
+      return false;
+    }
+  return (m_infected[nodeId / 64] >> (nodeId % 64)) & 1;
+}
+
+Time
+InfectionRegistry::GetTimeToFraction (double fraction) const
+{
+  uint32_t needed = static_cast<uint32_t> (std::ceil (fraction * m_population));
+  if (needed == 0)
+    {
+      needed = 1;
+    }
+  if (needed > m_records.size ())
+    {
+      return Time::Max ();
+    }
+  return m_records[needed - 1].time;
+}
+
+Time
+InfectionRegistry::GetInfectionTime (uint32_t nodeId) const
+{
+  if (!IsInfected (nodeId))
+    {
+      return Time::Max ();
+    }
+  return m_records[m_recordIndex[nodeId]].time;
+}
+
+uint32_t
+InfectionRegistry::GetInfector (uint32_t nodeId) const
+{
+  if (!IsInfected (nodeId))
+    {
+      return NO_INFECTOR;
+    }
+  return m_records[m_recordIndex[nodeId]].infectorId;
+}
+
+const std::vector<InfectionRecord> &
+InfectionRegistry::GetRecords (void) const
+{
+  return m_records;
+}
+
+void
+InfectionRegistry::NotifyInfection (uint32_t nodeId, Ipv4Address infector)
+{
+  NS_LOG_FUNCTION (this << nodeId << infector);
+  if (nodeId >= m_recordIndex.size () || IsInfected (nodeId))
+    {
+      return;
+    }
+
+  InfectionRecord record;
+  record.nodeId = nodeId;
+  record.infectorId = LookupNode (infector);
+  record.time = Simulator::Now ();
+  AddRecord (record);
+
+  if (m_stopWhenAll && m_count == m_population)
+    {
+      Simulator::Stop (m_stopDelay);
+    }
+}
+
+void
+InfectionRegistry::AddRecord (const InfectionRecord &record)
+{
+  m_infected[record.nodeId / 64] |= (uint64_t (1) << (record.nodeId % 64));
+  m_recordIndex[record.nodeId] = m_records.size ();
+  m_records.push_back (record);
+  m_count++;
+}
+
+void
+InfectionRegistry::AddAddress (Ipv4Address address, uint32_t nodeId)
+{
+  m_addresses.push_back (std::make_pair (address.Get (), nodeId));
+  m_addressesSorted = false;
+}
+
+uint32_t
+InfectionRegistry::LookupNode (Ipv4Address address) const
+{
+  if (!m_addressesSorted)
+    {
+      std::sort (m_addresses.begin (), m_addresses.end ());
+      m_addressesSorted = true;
+    }
+  std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it =
+    std::lower_bound (m_addresses.begin (), m_addresses.end (), std::make_pair (address.Get (), uint32_t (0)));
+  if (it == m_addresses.end () || it->first != address.Get ())
+    {
+      return NO_INFECTOR;
+    }
+  return it->second;
+}
+
+} // namespace ns3
@@ -0,0 +1,122 @@
+#ifndef INFECTION_REGISTRY_H
+#define INFECTION_REGISTRY_H
+
+#include <vector>
+#include <utility>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Node;
+class WormApplication;
+
+/**
+ * One infection, in the order it happened.
+ */
+struct InfectionRecord
+{
+  uint32_t nodeId;      //!< Node::GetId () of the infected node
+  uint32_t infectorId;  //!< Node::GetId () of the infector, or InfectionRegistry::NO_INFECTOR
+  Time time;            //!< simulation time of the infection
+};
+
+/**
+ * Run wide record of which worm hosts are infected, when, and by whom.
+ *
+ * Infection state is a dense bitset indexed by node id and the history
+ * is an append-only array of InfectionRecord, which is sorted by time by
+ * construction.  The infected count, the infection time and infector of a
+ * node and the time to reach a given fraction of the population are all
+ * O(1); resolving the infector address to a node is O(log n).
+ *
+ * The registry is fed by the "Infection" trace of every WormApplication
+ * passed to Track ().
+ */
+class InfectionRegistry : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  static const uint32_t NO_INFECTOR = 0xffffffff;
+
+  InfectionRegistry ();
+  virtual ~InfectionRegistry ();
+
+  /**
+   * Add the application to the population and follow its infections.
+   * Addresses must already be assigned to the node.
+   */
+  void Track (Ptr<WormApplication> app);
+
+  /**
+   * Add a worm host whose application lives on another MPI rank: it counts
+   * towards the population and its addresses resolve infectors, but its
+   * infections only arrive through Merge ().
+   */
+  void AddHost (Ptr<Node> node);
+
+  /**
+   * Exchange the infections every MPI rank recorded, after the run, so
+   * that every rank holds the complete, time ordered history.  A no-op
+   * without MPI.
+   */
+  void Merge (void);
+
+  /**
+   * Stop the simulation delay after the whole population is infected.
+   */
+  void StopWhenAllInfected (Time delay);
+
+  uint32_t GetPopulation (void) const;
+  uint32_t GetInfectedCount (void) const;
+  bool IsInfected (uint32_t nodeId) const;
+
+  /**
+   * \return the time at which fraction (0..1] of the population was
+   * infected, or Time::Max () if that has not happened (yet).
+   */
+  Time GetTimeToFraction (double fraction) const;
+
+  /**
+   * \return the infection time of the node, or Time::Max () if it is clean
+   */
+  Time GetInfectionTime (uint32_t nodeId) const;
+
+  /**
+   * \return the node id of the infector, or NO_INFECTOR for seeds and clean nodes
+   */
+  uint32_t GetInfector (uint32_t nodeId) const;
+
+  /**
+   * \return every infection in time order
+   */
+  const std::vector<InfectionRecord> & GetRecords (void) const;
+
+  /**
+   * Trace sink for WormApplication::Infection.
+   */
+  void NotifyInfection (uint32_t nodeId, Ipv4Address infector);
+
+private:
+  void AddAddress (Ipv4Address address, uint32_t nodeId);
+  void AddRecord (const InfectionRecord &record);
+  uint32_t LookupNode (Ipv4Address address) const;
+
+  std::vector<uint64_t> m_infected;       //!< one bit per node id
+  std::vector<uint32_t> m_recordIndex;    //!< node id -> index in m_records, NO_INFECTOR if clean
+  std::vector<InfectionRecord> m_records;
+  mutable std::vector<std::pair<uint32_t, uint32_t> > m_addresses; //!< (address, node id), sorted on demand
+  mutable bool m_addressesSorted;
+  uint32_t m_population;
+  uint32_t m_count;
+  bool m_stopWhenAll;
+  Time m_stopDelay;
+};
+
+} // namespace ns3
+
+#endif /* INFECTION_REGISTRY_H */
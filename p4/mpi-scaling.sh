@@ -0,0 +1,41 @@
+#!/bin/sh
+# Strong-scaling report for the distributed p4_tree and p4_barbell: the
+# same scenario on 1, 2, 4, 8 and 16 MPI ranks of one machine, with the
+# slowest rank's Simulator::Run wall time, the speedup over one rank and
+# the parallel efficiency.  Every run, the one-rank baseline included, uses
+# --mpi=true and so simulates to the scenario's end time without stopping
+# at full infection.
+#
+# Needs ns-3 configured with --enable-mpi.  Run from the ns-3 tree:
+#   WAF=./waf sh p4/mpi-scaling.sh > mpi-scaling.tsv
+# RANKS, TOPOLOGIES, TREE_ARGS and BARBELL_ARGS override the defaults; the
+# tree is split by subtree, so it needs at least as many nodes on some
+# level as there are ranks, and the barbell splits its leaves evenly over
+# all ranks.
+
+WAF=${WAF:-./waf}
+MPIRUN=${MPIRUN:-mpirun}
+RANKS=${RANKS:-"1 2 4 8 16"}
+TOPOLOGIES=${TOPOLOGIES:-"tree barbell"}
+TREE_ARGS=${TREE_ARGS:-"--depth=4 --fanout=8 --rootFanout=16"}
+BARBELL_ARGS=${BARBELL_ARGS:-"--nNodes=2000"}
+
+printf "topology\tranks\tnodes\trun_s\tspeedup\tefficiency\n"
+for topology in $TOPOLOGIES; do
+	case $topology in
+		tree) program=p4_tree; args=$TREE_ARGS ;;
+		barbell) program=p4_barbell; args=$BARBELL_ARGS ;;
+		*) echo "unknown topology $topology" >&2; exit 1 ;;
+	esac
+	base=""
+	for n in $RANKS; do
+		# Distributed <topology> ranks N nodes M run Ys
+		line=$($WAF --run $program --command-template="$MPIRUN -np $n %s $args --mpi=true" 2>/dev/null |
+			awk '$1 == "Distributed" { sub (/s$/, "", $8); print $4, $6, $8 }')
+		set -- $line
+		[ $# -eq 3 ] || { printf "%s\t%s\tfailed\n" $topology $n; continue; }
+		[ -n "$base" ] || base=$(awk -v r=$3 -v n=$n 'BEGIN { print r * n }')
+		awk -v t=$topology -v ranks=$1 -v nodes=$2 -v run=$3 -v base=$base 'BEGIN {
+			printf "%s\t%s\t%s\t%s\t%.2f\t%.2f\n", t, ranks, nodes, run, base / run, base / run / ranks }'
+	done
+done
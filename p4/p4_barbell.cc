@@ -20,385 +20,29 @@
 #include "ns3/point-to-point-layout-module.h"
 #include "ns3/netanim-module.h"
 
-#define MAX_CONNECTS 100
-
-using namespace ns3;
-
-uint16_t	globalInfectCount = 0;
-uint16_t	globalnNodes = 0;
-
-namespace ns3 {
-
-class Address;
-class Socket;
-
-
-
-class WormApplication : public Application
-{
-public:
-	static TypeId GetTypeId (void);
-	
-	WormApplication ();
-	
-	virtual ~WormApplication ();
-	
-	bool	isInfected();
-	
-	void	setAnimPoint(AnimationInterface *p);
-		
-
-protected:
-	virtual void DoDispose (void);
-private:
-	// inherited from Application base class.
-	virtual void StartApplication (void);    // Called at time specified by Start
-	virtual void StopApplication (void);     // Called at time specified by Stop
-	
-	//void SendData ();
-
-	Ptr<Socket>		m_socket;
-	Ptr<Socket>		m_sockets[MAX_CONNECTS];
-	Address			m_local;
-	Address			m_peer;
-	uint16_t		m_port;
-	uint32_t		m_sendSize;
-	uint32_t		m_cCount;
-	uint16_t		m_packsRec;
-	uint16_t		m_nodeID;
-	uint16_t		m_payload;
-	double			m_interval;
-	DataRate		m_dataRate; 
-	BooleanValue	m_infected;
-	TypeId			m_tid;
-	AnimationInterface *m_aP;
-
-	TracedCallback<Ptr<const Packet> > m_infectTrace;
-
-private:
-	void ConnectionSucceeded (Ptr<Socket> socket);
-	void NewPeer (Ptr<Socket> socket);
-	void HandleReceive (Ptr<Socket> socket);
-	void udpDataSend (Ptr<Socket> socket, uint32_t remaining);
-	void buildSendSockets ( void );
-};
-
-class WormHelper
-{
-	public:
-	WormHelper (std::string protocol, Address address);
-	
-	void SetAttribute (std::string name, const AttributeValue &value);
-	
-	ApplicationContainer Install (NodeContainer c) const;
-	
-	ApplicationContainer Install (Ptr<Node> node) const;
-	
-	ApplicationContainer Install (std::string nodeName) const;
-	
-	private:
-	Ptr<Application> InstallPriv (Ptr<Node> node) const;
-	
-	ObjectFactory m_factory; 
-};
-NS_LOG_COMPONENT_DEFINE ("WormApplication");
-
-NS_OBJECT_ENSURE_REGISTERED (WormApplication);
-
-WormHelper::WormHelper (std::string protocol, Address address)
-{
-  m_factory.SetTypeId ("ns3::WormApplication");
-  m_factory.Set ("Protocol", StringValue (protocol));
-  m_factory.Set ("Local", AddressValue (address));
-}
-
-void
-WormHelper::SetAttribute (std::string name, const AttributeValue &value)
-{
-  m_factory.Set (name, value);
-}
-
-ApplicationContainer
-WormHelper::Install (Ptr<Node> node) const
-{
-  return ApplicationContainer (InstallPriv (node));
-}
-
-ApplicationContainer
-WormHelper::Install (std::string nodeName) const
-{
-  Ptr<Node> node = Names::Find<Node> (nodeName);
-  return ApplicationContainer (InstallPriv (node));
-}
-
-ApplicationContainer
-WormHelper::Install (NodeContainer c) const
-{
-  ApplicationContainer apps;
-  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
-    {
-      apps.Add (InstallPriv (*i));
-    }
-
-  return apps;
-}
-
-Ptr<Application>
-WormHelper::InstallPriv (Ptr<Node> node) const
-{
-  Ptr<Application> app = m_factory.Create<Application> ();
-  node->AddApplication (app);
-
-  return app;
-}
-
-TypeId
-WormApplication::GetTypeId (void)
-{
-	static TypeId tid = TypeId ("ns3::WormApplication")
-	.SetParent<Application> ()
-	.AddConstructor<WormApplication> ()
-	.AddAttribute ("SendSize", "The amount of data to send each time.",
-					UintegerValue (32),
-					MakeUintegerAccessor (&WormApplication::m_sendSize),
-					MakeUintegerChecker<uint32_t> (1))
-	.AddAttribute ("DataRate", "The data rate in on state.",
-					DataRateValue (DataRate ("500kb/s")),
-					MakeDataRateAccessor (&WormApplication::m_dataRate),
-					MakeDataRateChecker ())
-	.AddAttribute ("Local",
-					"The Address on which to Bind the rx socket.",
-					AddressValue (),
-					MakeAddressAccessor (&WormApplication::m_local),
-					MakeAddressChecker ())
-	.AddAttribute ("Protocol", "The type of protocol to use.",
-					TypeIdValue (UdpSocketFactory::GetTypeId ()),
-					MakeTypeIdAccessor (&WormApplication::m_tid),
-					MakeTypeIdChecker ())
-	.AddAttribute ("Port", "Port on which we listen for incoming packets.",
-					UintegerValue(1000),
-					MakeUintegerAccessor (&WormApplication::m_port),
-					MakeUintegerChecker<uint16_t> ())
-	.AddAttribute ("ConnectCount", "Number of simultaneous send connects.",
-					UintegerValue(1),
-					MakeUintegerAccessor (&WormApplication::m_cCount),
-					MakeUintegerChecker<uint16_t> ())
-	.AddAttribute ("Infected", "State of infection.",
-					BooleanValue(false),
-					MakeBooleanAccessor (&WormApplication::m_infected),
-					MakeBooleanChecker())
-	.AddAttribute ("NodeID", "ID of node.",
-					UintegerValue(1),
-					MakeUintegerAccessor (&WormApplication::m_nodeID),
-					MakeUintegerChecker<uint16_t> ())	
-	.AddAttribute ("Interval", "Interval in seconds for peers choosing",
-					DoubleValue(1),
-					MakeDoubleAccessor(&WormApplication::m_interval),
-					MakeDoubleChecker<double> ())
-	.AddAttribute ("Payload", "Size of payload to send per interval in packets",
-					UintegerValue(10),
-					MakeUintegerAccessor (&WormApplication::m_payload),
-					MakeUintegerChecker<uint16_t> ())
-	.AddTraceSource ("InfectEvent", "The application is infected",
-                     MakeTraceSourceAccessor (&WormApplication::m_infectTrace))
-	
-	;
-  return tid;
-}
-
-WormApplication::WormApplication ()
-  : m_socket (0),
-	m_infected (false)
-{
-  NS_LOG_FUNCTION (this);
-  m_packsRec = 0;
-  m_cCount = 4;
-  m_aP = NULL;
-  for(uint32_t i = 0; i < MAX_CONNECTS; i++) {
-	  m_sockets[i] = NULL;
-  }
-}
-
-WormApplication::~WormApplication ()
-{
-  NS_LOG_FUNCTION (this);
-}
-
-void WormApplication::DoDispose (void)
-{
-	NS_LOG_FUNCTION (this);
-	m_socket = 0;
-	// chain up
-	Application::DoDispose ();
-}
-
-bool WormApplication::isInfected()
-{
-	return m_infected;
-}
-
-void WormApplication::setAnimPoint(AnimationInterface *p) {
-	m_aP = p;
-}
-
-void WormApplication::StartApplication ()    // Called at time specified by Start
-{
-	NS_LOG_FUNCTION (this);
-	// Create the socket if not already
-	if (!m_socket)
-	{
-		m_socket = Socket::CreateSocket (GetNode (), m_tid);
-		m_socket->Bind (m_local);
-		m_socket->Listen ();
-		
-		if(m_tid == TcpSocketFactory::GetTypeId ()) {
-			m_socket->SetConnectCallback (
-				MakeCallback (&WormApplication::ConnectionSucceeded, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-			m_socket->SetCloseCallbacks (
-				MakeCallback (&WormApplication::NewPeer, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-		}
-				
-	}
-	
-	m_socket->SetRecvCallback (MakeCallback (&WormApplication::HandleReceive, this));
-	if(m_infected == true ) {
-		//WormApplication::buildSendSockets();
-		WormApplication::NewPeer(m_socket);
-	}
-}
-
-void WormApplication::buildSendSockets (void) {
-	NS_LOG_FUNCTION(this);
-	for(uint32_t i = 0; i < m_cCount; i++) {
-		m_sockets[i] = Socket::CreateSocket (GetNode (), m_tid);
-		m_sockets[i]->Bind(m_local);
-		m_sockets[i]->Listen();
-		
-		if(m_tid == TcpSocketFactory::GetTypeId ()) {
-			m_sockets[i]->SetConnectCallback (
-				MakeCallback (&WormApplication::ConnectionSucceeded, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-			m_sockets[i]->SetCloseCallbacks (
-				MakeCallback (&WormApplication::NewPeer, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-		}
-		WormApplication::NewPeer(m_sockets[i]);
-	}
-}
-
-void WormApplication::HandleReceive (Ptr<Socket> socket)
-{
-	NS_LOG_FUNCTION (this << socket);
-	
-	Ptr<Packet> packet;
-	Ptr<Node> node;
-	node = socket->GetNode();
-	Address from;
-	while ((packet = socket->RecvFrom (from)))
-	{
-		if (InetSocketAddress::IsMatchingType (from))
-			{			
-				std::stringstream temp;
-				temp << InetSocketAddress::ConvertFrom (from).GetIpv4 ();
-				
-				uint16_t calcPayload = 1;
-				if (m_payload > 1) calcPayload = m_payload/2;
-				if(m_packsRec++ >= (calcPayload) && !m_infected) {
-					m_infected = true;
-					m_infectTrace (packet);
-					if (m_aP != NULL) {m_aP->UpdateNodeColor(node,0,0,250); }
-					/*std::cout << "Node "<< m_nodeID << " infected at " << 
-								Simulator::Now().GetSeconds() << "s by " << temp.str() << std::endl;*/
-					std::cout << Simulator::Now().GetSeconds() <<std::endl;
-
-					WormApplication::NewPeer(m_socket);
-				}
-			
-			}
-		
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
-	}
-}
-
-void WormApplication::StopApplication(void) {
-	NS_LOG_FUNCTION (this);
-	if (m_socket != 0)
-	{
-		m_socket->Close ();
-	}
-}
-
-void WormApplication::ConnectionSucceeded(Ptr<Socket> socket) {
-	NS_LOG_FUNCTION (this);
-	NS_LOG_INFO ("Found a sink!");
-	WormApplication::udpDataSend(socket, 10);
-}
-
-void WormApplication::NewPeer(Ptr<Socket> socket) {
-	NS_LOG_FUNCTION (this << socket);
-	std::stringstream temp;
-	int randAdd[4];
-	uint32_t randAdd32 = 0;
-	Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
-	U->SetAttribute ("Min", DoubleValue (0.0));
-	U->SetAttribute ("Max", DoubleValue (256));
-	Ptr<UniformRandomVariable> U2 = CreateObject<UniformRandomVariable> ();
-	U2->SetAttribute ("Min", DoubleValue (0));
-	U2->SetAttribute ("Max", DoubleValue (4));
-	
-	Ipv4Address newPeer;
-	
-	do {
-		randAdd[0] = 10;
-		randAdd[1] = 2;
-		randAdd[2] = U->GetValue();
-		randAdd[3] = 1;
-		randAdd32 |= randAdd[0]<<24;
-		randAdd32 |= randAdd[1]<<16;
-		randAdd32 |= randAdd[2]<<8;
-		randAdd32 |= randAdd[3];
+#include "worm.h"
+#include "infection-registry.h"
+#include "worm-trace.h"
+#include "tree-routing-helper.h"
+#include "dumbbell-topology-helper.h"
+#include "../common/address-plan.h"
+#include "../common/scale-probe.h"
+
+#include <algorithm>
+#include <sys/time.h>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#include "ns3/mpi-interface.h"
+#endif
 
-		newPeer.Set(randAdd32);
-	} while (InetSocketAddress (newPeer, m_port) == m_local);
-	
-	//NS_LOG_INFO ("Trying new peer! " << randAdd32 << " at " << Simulator::Now() << " from " << m_local);
-	
-	m_socket->Connect (InetSocketAddress (newPeer, m_port));
-	
-	if(m_tid == TcpSocketFactory::GetTypeId ()) {
-		;
-	}
-	else {
-		WormApplication::udpDataSend(socket, m_payload);
-	}
-	
-}
 
-void WormApplication::udpDataSend(Ptr<Socket> socket, uint32_t remaining) {
-	NS_LOG_FUNCTION(this);
-	
-	//NS_LOG_INFO (this << " Sending packet at " << Simulator::Now());
-	if( remaining > 0 ) {
-		Ptr<Packet> packet = Create<Packet> (m_sendSize);
-		socket->Send (packet);
-		Time onInterval = Seconds (m_interval/m_payload);
-		Simulator::Schedule (onInterval, &WormApplication::udpDataSend, this, socket, remaining-1 );
-	}
-	else {
-		WormApplication::NewPeer(socket);
-	}
-}
+using namespace ns3;
 
-} // namespace ns3
+NS_LOG_COMPONENT_DEFINE ("P4Barbell");
 
-void infectCounter ( ns3::Ptr<ns3::Packet const> a ) {
-	globalInfectCount++;
-	if ( globalInfectCount == globalnNodes ) {
-		Simulator::Stop (Seconds(0.1));
-	}
+void infectPrinter ( ns3::Ptr<ns3::Packet const> a ) {
+	std::cout << Simulator::Now().GetSeconds() <<std::endl;
 }
 
 
@@ -411,23 +55,30 @@ void txPacketCounter ( ns3::Ptr<ns3::Packet const> a ) {
 int main(int argc, char *argv[]) {
 	
 	LogComponentEnable ("WormApplication", LOG_LEVEL_INFO);
+	LogComponentEnable ("P4Barbell", LOG_LEVEL_INFO);
 	//LogComponentEnable ("PacketSink", LOG_LEVEL_ALL);
 
 	
 	//LogComponentEnable ("Ipv4AddressHelper", LOG_LEVEL_ALL);
 	//LogComponentEnable ("Socket", LOG_LEVEL_ALL);
 	
-	Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
-	U->SetAttribute ("Stream", IntegerValue (6110));
-	U->SetAttribute ("Min", DoubleValue (0.0));
-	U->SetAttribute ("Max", DoubleValue (0.1));
-	
 	Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpTahoe"));
 	
 	
 	uint32_t	nNodes = 50;
 	uint32_t	scanRate = 10;
 	uint32_t	payload = 10;
+	bool		burstSend = false;
+	bool		netanim = false;
+	std::string	traceFile = "";
+	std::string	routing = "tree";
+	bool		scaleReport = false;
+	bool		mpi = false;
+	bool		elideMisses = false;
+	std::string	scanStrategy = "ns3::UniformScanStrategy";
+	std::string	transport = "udp";
+	bool		sharedPayload = false;
+	uint32_t	connectCount = 1;
 	double		interval = 1;
 	double		endTime = 20.0;
 	
@@ -436,14 +87,57 @@ int main(int argc, char *argv[]) {
 	cmd.AddValue ("nNodes", "Number of flows and nodes", nNodes);
 	cmd.AddValue ("scanRate","Worm scan rate in nodes per second", scanRate);
 	cmd.AddValue ("Payload","Worm payload packet count per scan", payload);
+	cmd.AddValue ("burstSend","Queue worm packet trains ahead of time while the access link is busy", burstSend);
+	cmd.AddValue ("netanim","Write NetAnim XML with packet metadata while running (slow)", netanim);
+	cmd.AddValue ("traceFile","Write a compact binary infection/link trace to this file", traceFile);
+	cmd.AddValue ("routing","Route setup: tree (static, linear) or global (Ipv4GlobalRoutingHelper)", routing);
+	cmd.AddValue ("scaleReport","Print setup time, event rate and peak RSS (see common/scale-bench.sh)", scaleReport);
+	cmd.AddValue ("mpi","Run distributed: the two sides of the dumbbell go to different mpirun ranks", mpi);
+	cmd.AddValue ("elideMisses","Count worm scans to unassigned addresses instead of sending them", elideMisses);
+	cmd.AddValue ("scanStrategy","Worm target selection, a WormScanStrategy TypeId such as ns3::PermutationScanStrategy", scanStrategy);
+	cmd.AddValue ("transport","Worm transport: udp (sockets) or raw (bare IPv4, WormL4Protocol)", transport);
+	cmd.AddValue ("sharedPayload","Send copies of one template worm packet instead of building every packet", sharedPayload);
+	cmd.AddValue ("connectCount","Scans every infected worm runs at once", connectCount);
 	cmd.Parse (argc, argv);
+	NS_ABORT_MSG_UNLESS (transport == "udp" || transport == "raw", "Unknown --transport=" << transport << ", use udp or raw");
+	std::string wormProtocol = transport == "raw" ? "ns3::WormL4Protocol" : "ns3::UdpSocketFactory";
+	
+	uint32_t systemId = 0;
+	uint32_t systems = 1;
+	if (mpi) {
+#ifdef NS3_MPI
+		NS_ABORT_MSG_IF (scaleReport || netanim || traceFile != "", "--mpi does not combine with --scaleReport, --netanim or --traceFile");
+		GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+		MpiInterface::Enable (&argc, &argv);
+		systemId = MpiInterface::GetSystemId ();
+		systems = MpiInterface::GetSize ();
+#else
+		NS_ABORT_MSG ("--mpi needs ns-3 configured with --enable-mpi");
+#endif
+	}
+	
+	// created after parsing so that --RngRun reaches its stream
+	Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
+	U->SetAttribute ("Stream", IntegerValue (6110));
+	U->SetAttribute ("Min", DoubleValue (0.0));
+	U->SetAttribute ("Max", DoubleValue (0.1));
+	
+	ScaleProbe probe;
+	if (scaleReport) probe.Start ();
+	
+	Config::SetDefault ("ns3::WormApplication::BurstSend", BooleanValue (burstSend));
+	Config::SetDefault ("ns3::WormApplication::ElideMisses", BooleanValue (elideMisses));
+	Config::SetDefault ("ns3::WormApplication::SharedPayload", BooleanValue (sharedPayload));
+	Config::SetDefault ("ns3::WormApplication::ConnectCount", UintegerValue (connectCount));
+	Config::SetDefault ("ns3::WormApplication::ScanStrategy", StringValue (scanStrategy));
+	// the hit list holds the right leaf links, which come after the
+	// bottleneck and the left leaf links
+	Config::SetDefault ("ns3::HitListScanStrategy::Offset", UintegerValue (1 + nNodes));
+	Config::SetDefault ("ns3::HitListScanStrategy::Size", UintegerValue (nNodes));
 	
 	interval = (double)1 / ( scanRate );
 	NS_LOG_INFO("Using worm peer interval of " << interval << "s");
 	
-	if( nNodes > 200 ) nNodes = 200;
-	globalnNodes = nNodes;
-	
 	if( payload > 80000 ) payload = 80000;
 	if( payload < 1 ) payload =1;
 	
@@ -461,35 +155,56 @@ int main(int argc, char *argv[]) {
 	rightHelper.SetChannelAttribute ("Delay", StringValue ("10ms"));
 	
 	NS_LOG_INFO("Creating " << nNodes << " sources and sinks.");
-	PointToPointDumbbellHelper dumbBell (nNodes,leftHelper, nNodes, rightHelper, bottleneckHelper);
+	DumbbellTopologyHelper dumbBell (nNodes,leftHelper, nNodes, rightHelper, bottleneckHelper, systems);
 		
 	dumbBell.BoundingBox(1,1,100,100);
 	
 	// Create the animation object and configure for specified output
-	AnimationInterface anim ("p4anim.xml");
-	AnimationInterface *aP = &anim;
-	aP->EnablePacketMetadata (); // Optional
+	AnimationInterface *aP = NULL;
+	if (netanim) {
+		aP = new AnimationInterface ("p4anim.xml");
+		aP->EnablePacketMetadata ();
+	}
+	
+	Ptr<WormTraceWriter> trace;
+	if (traceFile != "") {
+		trace = CreateObject<WormTraceWriter> ();
+		trace->Open (traceFile);
+	}
 	
 	InternetStackHelper stack;
 	dumbBell.InstallStack (stack);
 	
-	Ipv4AddressHelper ipv4L;
-	ipv4L.SetBase ("10.3.1.0", "255.255.255.0");
-	Ipv4AddressHelper ipv4B;
-	ipv4B.SetBase ("10.1.1.0", "255.255.255.0");
-	Ipv4AddressHelper ipv4R;
-	ipv4R.SetBase ("10.2.1.0", "255.255.255.0");
-	
 	NS_LOG_INFO ("Assign IP Addresses.");
-	dumbBell.AssignIpv4Addresses(ipv4L, ipv4R, ipv4B);
+	// one /30 per link, every rank holds every node
+	AddressPlan plan;
+	dumbBell.AssignIpv4Addresses (plan);
 	
 	NS_LOG_INFO ("Create Applications.");
 	
 		
 	
-	ApplicationContainer wormLApps[1000];
+	Ptr<InfectionRegistry> registry = CreateObject<InfectionRegistry> ();
+	// a rank only sees its own infections until the registries are merged,
+	// so a distributed run always goes to endTime; so does a one-rank --mpi
+	// run, or mpi-scaling.sh would compare it against a shorter horizon
+	if (!mpi) registry->StopWhenAllInfected (Seconds (0.1));
+	
+	// one target per /30 link handed out above, leaf side; the default
+	// barbell keeps the original 256 targets
+	uint32_t nLinks = 1 + 2 * nNodes;
+	uint32_t scanRange = std::max<uint32_t> (256, nLinks);
+	
+	int64_t streamIndex = 0;
+	ApplicationContainer wormApps;
 	for(uint32_t i = 0; i < 1; ++i) {
-		WormHelper worm ("ns3::UdpSocketFactory", InetSocketAddress (dumbBell.GetLeftIpv4Address(i), 5001));
+		if (dumbBell.GetLeft (i)->GetSystemId () != systemId) {
+			// keep the stream numbering of a single-rank run
+			registry->AddHost (dumbBell.GetLeft (i));
+			streamIndex++;
+			continue;
+		}
+		WormHelper worm (wormProtocol, InetSocketAddress (dumbBell.GetLeftIpv4Address(i), 5001));
 		if(i == 0){ 
 			worm.SetAttribute("Infected",BooleanValue(true));
 		}
@@ -497,39 +212,59 @@ int main(int argc, char *argv[]) {
 		worm.SetAttribute("Port",UintegerValue(5001));
 		worm.SetAttribute("Interval",DoubleValue(interval));
 		worm.SetAttribute("Payload",UintegerValue(payload));
-		wormLApps[i] = worm.Install (dumbBell.GetLeft (i));
-		wormLApps[i].Start (Seconds (0.0));
-		wormLApps[i].Stop (Seconds (endTime));
+		worm.SetAttribute("InfectThreshold",UintegerValue(payload > 1 ? payload/2 : 1));
+		worm.SetAttribute("ScanNetwork",Ipv4AddressValue("10.0.0.0"));
+		worm.SetAttribute("ScanHost",UintegerValue(1));
+		worm.SetAttribute("ScanRange",UintegerValue(scanRange));
+		worm.SetAttribute("ScanStride",UintegerValue(4));
+		worm.SetAttribute("PrintInfections",BooleanValue(false));
+		ApplicationContainer app = worm.Install (dumbBell.GetLeft (i));
+		streamIndex += worm.AssignStreams (dumbBell.GetLeft (i), streamIndex);
+		wormApps.Add (app);
 		
-		Ptr<Application>	app;
-		app = wormLApps[i].Get(0);
-		app->TraceConnectWithoutContext ( "InfectEvent", MakeCallback (&infectCounter));
+		app.Get(0)->TraceConnectWithoutContext ( "InfectEvent", MakeCallback (&infectPrinter));
 		Ptr<WormApplication> wApp;
-		wApp = DynamicCast<WormApplication> (wormLApps[i].Get(0));
+		wApp = DynamicCast<WormApplication> (app.Get(0));
 		wApp->setAnimPoint(aP);
+		wApp->SetTargetIndex (&plan);
+		registry->Track (wApp);
+		if (trace) trace->Track (wApp);
 	}
 	
-	ApplicationContainer wormRApps[1000];
 	for(uint32_t i = 0; i < nNodes; ++i) {
-		WormHelper worm ("ns3::UdpSocketFactory", InetSocketAddress (dumbBell.GetRightIpv4Address(i), 5001));
+		if (dumbBell.GetRight (i)->GetSystemId () != systemId) {
+			registry->AddHost (dumbBell.GetRight (i));
+			streamIndex++;
+			continue;
+		}
+		WormHelper worm (wormProtocol, InetSocketAddress (dumbBell.GetRightIpv4Address(i), 5001));
 		worm.SetAttribute("NodeID",UintegerValue(i+nNodes));
 		worm.SetAttribute("Port",UintegerValue(5001));
 		worm.SetAttribute("Interval",DoubleValue(interval));
-		wormRApps[i] = worm.Install (dumbBell.GetRight (i));
-		wormRApps[i].Start (Seconds (0.0));
-		wormRApps[i].Stop (Seconds (endTime));
+		// right side keeps the default 10 packet payload
+		worm.SetAttribute("InfectThreshold",UintegerValue(5));
+		worm.SetAttribute("ScanNetwork",Ipv4AddressValue("10.0.0.0"));
+		worm.SetAttribute("ScanHost",UintegerValue(1));
+		worm.SetAttribute("ScanRange",UintegerValue(scanRange));
+		worm.SetAttribute("ScanStride",UintegerValue(4));
+		worm.SetAttribute("PrintInfections",BooleanValue(false));
+		ApplicationContainer app = worm.Install (dumbBell.GetRight (i));
+		streamIndex += worm.AssignStreams (dumbBell.GetRight (i), streamIndex);
+		wormApps.Add (app);
 		
-		Ptr<Application>	app;
-		app = wormRApps[i].Get(0);
-		app->TraceConnectWithoutContext ( "InfectEvent", MakeCallback (&infectCounter));
+		app.Get(0)->TraceConnectWithoutContext ( "InfectEvent", MakeCallback (&infectPrinter));
 		Ptr<WormApplication> wApp;
-		wApp = DynamicCast<WormApplication> (wormRApps[i].Get(0));
+		wApp = DynamicCast<WormApplication> (app.Get(0));
 		wApp->setAnimPoint(aP);
+		wApp->SetTargetIndex (&plan);
+		registry->Track (wApp);
+		if (trace) trace->Track (wApp);
 	}
+	wormApps.Start (Seconds (0.0));
+	wormApps.Stop (Seconds (endTime));
 
 #if 0 //Background Traffic	
-	double rn[nNodes];
-	ApplicationContainer sourceApps[200];
+	ApplicationContainer sourceApps;
 		for(uint32_t i = 0; i < nNodes; ++i) {
 		OnOffHelper source ("ns3::TcpSocketFactory",
 								 InetSocketAddress (dumbBell.GetRightIpv4Address(i), 1000));
@@ -537,46 +272,75 @@ int main(int argc, char *argv[]) {
 		source.SetAttribute ("PacketSize", UintegerValue (128));
 		source.SetAttribute ("OnTime", StringValue ("ns3::UniformRandomVariable[Min=0.,Max=1.]"));
 		source.SetAttribute ("OffTime", StringValue ("ns3::UniformRandomVariable[Min=0.,Max=1.]"));
-		sourceApps[i] = source.Install (dumbBell.GetLeft (i));
-		rn[i] = U->GetValue();
-		sourceApps[i].Start (Seconds (rn[i]));
-		sourceApps[i].Stop (Seconds (endTime));
-	}
-	
-	for(uint32_t i = 0; i < nNodes; ++i) {
-		Ptr<Application>	app;
-		app = (sourceApps[i].Get(0));
-		app->TraceConnectWithoutContext ( "Tx", MakeCallback (&txPacketCounter));
+		ApplicationContainer app = source.Install (dumbBell.GetLeft (i));
+		app.Start (Seconds (U->GetValue()));
+		app.Stop (Seconds (endTime));
+		app.Get(0)->TraceConnectWithoutContext ( "Tx", MakeCallback (&txPacketCounter));
+		sourceApps.Add (app);
 	}
 
-  ApplicationContainer sinkApps[200];
+  ApplicationContainer sinkApps;
   for(uint32_t i = 0; i < nNodes; ++i) {
     PacketSinkHelper sink ("ns3::TcpSocketFactory",
                          InetSocketAddress (dumbBell.GetRightIpv4Address(i), 1000));
-  	sinkApps[i] = sink.Install (dumbBell.GetRight (i));
-	sinkApps[i].Start (Seconds (0.0));
-    sinkApps[i].Stop (Seconds (endTime));
+  	sinkApps.Add (sink.Install (dumbBell.GetRight (i)));
   }
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (endTime));
  #endif
 
 	
 		
-	//Turn on global static routing
-	Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+	TreeRoutingHelper::Populate (routing, dumbBell.GetLeft ());
 	
+	if (trace) trace->Start ();
+	
+	probe.SetupDone ();
+	struct timeval runStart, runEnd;
+	gettimeofday (&runStart, 0);
 	Simulator::Stop (Seconds (endTime));
 	Simulator::Run ();
+	gettimeofday (&runEnd, 0);
+	probe.RunDone ();
+	if (trace) trace->Close ();
+	double runTime = (runEnd.tv_sec - runStart.tv_sec) + (runEnd.tv_usec - runStart.tv_usec) * 1e-6;
+	registry->Merge ();
+	uint64_t elided[2] = { 0, 0 };	// scans, bytes
+	for (ApplicationContainer::Iterator it = wormApps.Begin (); it != wormApps.End (); ++it) {
+		elided[0] += DynamicCast<WormApplication> (*it)->GetElidedScans ();
+		elided[1] += DynamicCast<WormApplication> (*it)->GetElidedBytes ();
+	}
+	uint64_t templates[2] = { PayloadTemplate::GetNBuilt (), PayloadTemplate::GetNCopies () };
+#ifdef NS3_MPI
+	if (mpi) {
+		double slowest = runTime;
+		MPI_Reduce (&runTime, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		runTime = slowest;
+		uint64_t local[2] = { elided[0], elided[1] };
+		MPI_Reduce (local, elided, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+		uint64_t localTemplates[2] = { templates[0], templates[1] };
+		MPI_Reduce (localTemplates, templates, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	}
+#endif
 	Simulator::Destroy ();
+	delete aP;
 	
-	double infectCount = 0;
-	Ptr<WormApplication> wApp;
-	
-	
-	for( uint32_t i = 0; i < nNodes; ++i ) {
-		wApp = DynamicCast<WormApplication> (wormRApps[i].Get(0));
-		if ( wApp->isInfected() ) {infectCount++;}
+	if (systemId == 0) {
+		std::cout << registry->GetInfectedCount () << " nodes infected."<< std::endl;
+		if (sharedPayload) {
+			PayloadTemplate::Print (std::cout, templates[0], templates[1]);
+		}
+		if (elideMisses) {
+			std::cout << "Elided " << elided[0] << " scans, " << elided[1] << " bytes the elided scans would have sent" << std::endl;
+		}
+		if (mpi) {
+			std::cout << "Distributed barbell ranks " << systems << " nodes " << 2 * nNodes + 2 << " run " << runTime << "s" << std::endl;
+		}
 	}
-	std::cout << infectCount << " nodes infected."<< std::endl;
+	probe.Print (std::cout, "barbell");
+#ifdef NS3_MPI
+	if (mpi) MpiInterface::Disable ();
+#endif
 
 #if 0 //Background Traffic
 	double totaRxlBytes = 0;
@@ -584,7 +348,7 @@ int main(int argc, char *argv[]) {
 	Ptr<PacketSink> sink1;
 	
 	for( uint32_t i = 0; i < nNodes; ++i ) {
-		sink1 = DynamicCast<PacketSink> (sinkApps[i].Get(0));
+		sink1 = DynamicCast<PacketSink> (sinkApps.Get(i));
 		totaRxlBytes += sink1->GetTotalRx ();
 	}
 	efficiency =  totaRxlBytes/globalTxBytes;
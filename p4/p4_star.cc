@@ -20,397 +20,27 @@
 #include "ns3/point-to-point-layout-module.h"
 #include "ns3/netanim-module.h"
 
-#define MAX_CONNECTS 100
+#include "worm.h"
+#include "infection-registry.h"
+#include "worm-trace.h"
+#include "tree-routing-helper.h"
+#include "../common/address-plan.h"
+#include "../common/scale-probe.h"
 
-using namespace ns3;
-
-uint16_t	globalInfectCount = 0;
-uint16_t	globalnNodes = 0;
-
-namespace ns3 {
-
-class Address;
-class Socket;
-
-
-
-class WormApplication : public Application
-{
-public:
-	static TypeId GetTypeId (void);
-	
-	WormApplication ();
-	
-	virtual ~WormApplication ();
-	
-	bool	isInfected();
-	
-	void	setAnimPoint(AnimationInterface *p);
-		
-
-protected:
-	virtual void DoDispose (void);
-private:
-	// inherited from Application base class.
-	virtual void StartApplication (void);    // Called at time specified by Start
-	virtual void StopApplication (void);     // Called at time specified by Stop
-	
-	//void SendData ();
-
-	Ptr<Socket>		m_socket;
-	Ptr<Socket>		m_sockets[MAX_CONNECTS];
-	Address			m_local;
-	Address			m_peer;
-	uint16_t		m_port;
-	uint32_t		m_sendSize;
-	uint32_t		m_cCount;
-	uint16_t		m_packsRec;
-	uint16_t		m_nodeID;
-	uint16_t		m_payload;
-	double			m_interval;
-	DataRate		m_dataRate; 
-	BooleanValue	m_infected;
-	TypeId			m_tid;
-	AnimationInterface *m_aP;
-
-	TracedCallback<Ptr<const Packet> > m_infectTrace;
-
-private:
-	void ConnectionSucceeded (Ptr<Socket> socket);
-	void NewPeer (Ptr<Socket> socket);
-	void HandleReceive (Ptr<Socket> socket);
-	void udpDataSend (Ptr<Socket> socket, uint32_t remaining);
-	void buildSendSockets ( void );
-};
-
-class WormHelper
-{
-	public:
-	WormHelper (std::string protocol, Address address);
-	
-	void SetAttribute (std::string name, const AttributeValue &value);
-	
-	ApplicationContainer Install (NodeContainer c) const;
-	
-	ApplicationContainer Install (Ptr<Node> node) const;
-	
-	ApplicationContainer Install (std::string nodeName) const;
-	
-	private:
-	Ptr<Application> InstallPriv (Ptr<Node> node) const;
-	
-	ObjectFactory m_factory; 
-};
-NS_LOG_COMPONENT_DEFINE ("WormApplication");
-
-NS_OBJECT_ENSURE_REGISTERED (WormApplication);
-
-WormHelper::WormHelper (std::string protocol, Address address)
-{
-  m_factory.SetTypeId ("ns3::WormApplication");
-  m_factory.Set ("Protocol", StringValue (protocol));
-  m_factory.Set ("Local", AddressValue (address));
-}
-
-void
-WormHelper::SetAttribute (std::string name, const AttributeValue &value)
-{
-  m_factory.Set (name, value);
-}
-
-ApplicationContainer
-WormHelper::Install (Ptr<Node> node) const
-{
-  return ApplicationContainer (InstallPriv (node));
-}
-
-ApplicationContainer
-WormHelper::Install (std::string nodeName) const
-{
-  Ptr<Node> node = Names::Find<Node> (nodeName);
-  return ApplicationContainer (InstallPriv (node));
-}
-
-ApplicationContainer
-WormHelper::Install (NodeContainer c) const
-{
-  ApplicationContainer apps;
-  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
-    {
-      apps.Add (InstallPriv (*i));
-    }
-
-  return apps;
-}
-
-Ptr<Application>
-WormHelper::InstallPriv (Ptr<Node> node) const
-{
-  Ptr<Application> app = m_factory.Create<Application> ();
-  node->AddApplication (app);
-
-  return app;
-}
-
-TypeId
-WormApplication::GetTypeId (void)
-{
-	static TypeId tid = TypeId ("ns3::WormApplication")
-	.SetParent<Application> ()
-	.AddConstructor<WormApplication> ()
-	.AddAttribute ("SendSize", "The amount of data to send each time.",
-					UintegerValue (32),
-					MakeUintegerAccessor (&WormApplication::m_sendSize),
-					MakeUintegerChecker<uint32_t> (1))
-	.AddAttribute ("DataRate", "The data rate in on state.",
-					DataRateValue (DataRate ("500kb/s")),
-					MakeDataRateAccessor (&WormApplication::m_dataRate),
-					MakeDataRateChecker ())
-	.AddAttribute ("Local",
-					"The Address on which to Bind the rx socket.",
-					AddressValue (),
-					MakeAddressAccessor (&WormApplication::m_local),
-					MakeAddressChecker ())
-	.AddAttribute ("Protocol", "The type of protocol to use.",
-					TypeIdValue (UdpSocketFactory::GetTypeId ()),
-					MakeTypeIdAccessor (&WormApplication::m_tid),
-					MakeTypeIdChecker ())
-	.AddAttribute ("Port", "Port on which we listen for incoming packets.",
-					UintegerValue(1000),
-					MakeUintegerAccessor (&WormApplication::m_port),
-					MakeUintegerChecker<uint16_t> ())
-	.AddAttribute ("ConnectCount", "Number of simultaneous send connects.",
-					UintegerValue(1),
-					MakeUintegerAccessor (&WormApplication::m_cCount),
-					MakeUintegerChecker<uint16_t> ())
-	.AddAttribute ("Infected", "State of infection.",
-					BooleanValue(false),
-					MakeBooleanAccessor (&WormApplication::m_infected),
-					MakeBooleanChecker())
-	.AddAttribute ("NodeID", "ID of node.",
-					UintegerValue(1),
-					MakeUintegerAccessor (&WormApplication::m_nodeID),
-					MakeUintegerChecker<uint16_t> ())	
-	.AddAttribute ("Interval", "Interval in seconds for peers choosing",
-					DoubleValue(1),
-					MakeDoubleAccessor(&WormApplication::m_interval),
-					MakeDoubleChecker<double> ())
-	.AddAttribute ("Payload", "Size of payload to send per interval in packets",
-					UintegerValue(10),
-					MakeUintegerAccessor (&WormApplication::m_payload),
-					MakeUintegerChecker<uint16_t> ())
-	.AddTraceSource ("InfectEvent", "The application is infected",
-                     MakeTraceSourceAccessor (&WormApplication::m_infectTrace))
-	
-	;
-  return tid;
-}
+#include <algorithm>
 
-WormApplication::WormApplication ()
-  : m_socket (0),
-	m_infected (false)
-{
-  NS_LOG_FUNCTION (this);
-  m_packsRec = 0;
-  m_cCount = 4;
-  m_aP = NULL;
-  for(uint32_t i = 0; i < MAX_CONNECTS; i++) {
-	  m_sockets[i] = NULL;
-  }
-}
 
-WormApplication::~WormApplication ()
-{
-  NS_LOG_FUNCTION (this);
-}
-
-void WormApplication::DoDispose (void)
-{
-	NS_LOG_FUNCTION (this);
-	m_socket = 0;
-	// chain up
-	Application::DoDispose ();
-}
-
-bool WormApplication::isInfected()
-{
-	return m_infected;
-}
-
-void WormApplication::setAnimPoint(AnimationInterface *p) {
-	m_aP = p;
-}
-
-void WormApplication::StartApplication ()    // Called at time specified by Start
-{
-	NS_LOG_FUNCTION (this);
-	// Create the socket if not already
-	if (!m_socket)
-	{
-		m_socket = Socket::CreateSocket (GetNode (), m_tid);
-		m_socket->Bind (m_local);
-		m_socket->Listen ();
-		
-		if(m_tid == TcpSocketFactory::GetTypeId ()) {
-			m_socket->SetConnectCallback (
-				MakeCallback (&WormApplication::ConnectionSucceeded, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-			m_socket->SetCloseCallbacks (
-				MakeCallback (&WormApplication::NewPeer, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-		}
-				
-	}
-	
-	m_socket->SetRecvCallback (MakeCallback (&WormApplication::HandleReceive, this));
-	if(m_infected == true ) {
-		//WormApplication::buildSendSockets();
-		WormApplication::NewPeer(m_socket);
-	}
-}
-
-void WormApplication::buildSendSockets (void) {
-	NS_LOG_FUNCTION(this);
-	for(uint32_t i = 0; i < m_cCount; i++) {
-		m_sockets[i] = Socket::CreateSocket (GetNode (), m_tid);
-		m_sockets[i]->Bind(m_local);
-		m_sockets[i]->Listen();
-		
-		if(m_tid == TcpSocketFactory::GetTypeId ()) {
-			m_sockets[i]->SetConnectCallback (
-				MakeCallback (&WormApplication::ConnectionSucceeded, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-			m_sockets[i]->SetCloseCallbacks (
-				MakeCallback (&WormApplication::NewPeer, this),
-				MakeCallback (&WormApplication::NewPeer, this));
-		}
-		WormApplication::NewPeer(m_sockets[i]);
-	}
-}
-
-void WormApplication::HandleReceive (Ptr<Socket> socket)
-{
-	NS_LOG_FUNCTION (this << socket);
-	
-	Ptr<Packet> packet;
-	Ptr<Node> node;
-	node = socket->GetNode();
-	Address from;
-	while ((packet = socket->RecvFrom (from)))
-	{
-		if (InetSocketAddress::IsMatchingType (from))
-			{			
-				std::stringstream temp;
-				temp << InetSocketAddress::ConvertFrom (from).GetIpv4 ();
-				
-				uint16_t calcPayload = 1;
-				if (m_payload > 1) calcPayload = m_payload/2;
-				if(m_packsRec++ >= (calcPayload) && !m_infected) {
-					m_infected = true;
-					m_infectTrace (packet);
-					if (m_aP != NULL) {m_aP->UpdateNodeColor(node,0,0,250); }
-					std::cout << "Node "<< m_nodeID << " infected at " << 
-								Simulator::Now().GetSeconds() << "s by " << temp.str() << std::endl;
-
-					WormApplication::NewPeer(m_socket);
-				}
-			
-			}
-		
-		packet->RemoveAllPacketTags ();
-		packet->RemoveAllByteTags ();
-	}
-}
-
-void WormApplication::StopApplication(void) {
-	NS_LOG_FUNCTION (this);
-	if (m_socket != 0)
-	{
-		m_socket->Close ();
-	}
-}
-
-void WormApplication::ConnectionSucceeded(Ptr<Socket> socket) {
-	NS_LOG_FUNCTION (this);
-	NS_LOG_INFO ("Found a sink!");
-	WormApplication::udpDataSend(socket, 10);
-}
-
-void WormApplication::NewPeer(Ptr<Socket> socket) {
-	NS_LOG_FUNCTION (this << socket);
-	std::stringstream temp;
-	int randAdd[4];
-	uint32_t randAdd32 = 0;
-	Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
-	U->SetAttribute ("Min", DoubleValue (0.0));
-	U->SetAttribute ("Max", DoubleValue (256));
-	Ptr<UniformRandomVariable> U2 = CreateObject<UniformRandomVariable> ();
-	U2->SetAttribute ("Min", DoubleValue (0));
-	U2->SetAttribute ("Max", DoubleValue (4));
-	
-	Ipv4Address newPeer;
-	
-	do {
-		randAdd[0] = 10;
-		randAdd[1] = 2;
-		randAdd[2] = U->GetValue();
-		randAdd[3] = 2;
-		randAdd32 |= randAdd[0]<<24;
-		randAdd32 |= randAdd[1]<<16;
-		randAdd32 |= randAdd[2]<<8;
-		randAdd32 |= randAdd[3];
-
-		newPeer.Set(randAdd32);
-	} while (InetSocketAddress (newPeer, m_port) == m_local);
-	
-	//NS_LOG_INFO ("Trying new peer! " << randAdd32 << " at " << Simulator::Now() << " from " << m_local);
-	
-	m_socket->Connect (InetSocketAddress (newPeer, m_port));
-	
-	if(m_tid == TcpSocketFactory::GetTypeId ()) {
-		;
-	}
-	else {
-		WormApplication::udpDataSend(socket, m_payload);
-	}
-	
-}
-
-void WormApplication::udpDataSend(Ptr<Socket> socket, uint32_t remaining) {
-	NS_LOG_FUNCTION(this);
-	
-	//NS_LOG_INFO (this << " Sending packet at " << Simulator::Now());
-	if( remaining > 0 ) {
-		Ptr<Packet> packet = Create<Packet> (m_sendSize);
-		socket->Send (packet);
-		Time onInterval = Seconds (m_interval/m_payload);
-		Simulator::Schedule (onInterval, &WormApplication::udpDataSend, this, socket, remaining-1 );
-	}
-	else {
-		WormApplication::NewPeer(socket);
-	}
-}
-
-} // namespace ns3
+using namespace ns3;
 
-void infectCounter ( ns3::Ptr<ns3::Packet const> a ) {
-	globalInfectCount++;
-	if ( globalInfectCount == globalnNodes ) {
-		Simulator::Stop (Seconds(0.1));
-	}
-}
+NS_LOG_COMPONENT_DEFINE ("P4Star");
 
 int main(int argc, char *argv[]) {
 	
 	LogComponentEnable ("WormApplication", LOG_LEVEL_INFO);
+	LogComponentEnable ("P4Star", LOG_LEVEL_INFO);
 	//LogComponentEnable ("Ipv4AddressHelper", LOG_LEVEL_ALL);
 	//LogComponentEnable ("Socket", LOG_LEVEL_ALL);
 	
-	Ptr<UniformRandomVariable> U = CreateObject<UniformRandomVariable> ();
-	U->SetAttribute ("Stream", IntegerValue (6110));
-	U->SetAttribute ("Min", DoubleValue (0.0));
-	U->SetAttribute ("Max", DoubleValue (0.1));
-	
 	Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpTahoe"));
 	Config::SetDefault ("ns3::TcpSocket::ConnTimeout", TimeValue (NanoSeconds(1000)));
 	
@@ -418,6 +48,16 @@ int main(int argc, char *argv[]) {
 	uint32_t	nNodes = 50;
 	uint32_t	scanRate = 10;
 	uint32_t	payload = 10;
+	bool		burstSend = false;
+	bool		netanim = false;
+	std::string	traceFile = "";
+	std::string	routing = "tree";
+	bool		scaleReport = false;
+	bool		elideMisses = false;
+	std::string	scanStrategy = "ns3::UniformScanStrategy";
+	std::string	transport = "udp";
+	bool		sharedPayload = false;
+	uint32_t	connectCount = 1;
 	double		interval = 0.1;
 	double		endTime = 10;
 	
@@ -426,14 +66,35 @@ int main(int argc, char *argv[]) {
 	cmd.AddValue ("nNodes", "Number of flows and nodes", nNodes);
 	cmd.AddValue ("scanRate","Worm scan rate in nodes per second", scanRate);
 	cmd.AddValue ("Payload","Worm payload packet count per scan", payload);
+	cmd.AddValue ("burstSend","Queue worm packet trains ahead of time while the access link is busy", burstSend);
+	cmd.AddValue ("netanim","Write NetAnim XML with packet metadata while running (slow)", netanim);
+	cmd.AddValue ("traceFile","Write a compact binary infection/link trace to this file", traceFile);
+	cmd.AddValue ("routing","Route setup: tree (static, linear) or global (Ipv4GlobalRoutingHelper)", routing);
+	cmd.AddValue ("scaleReport","Print setup time, event rate and peak RSS (see common/scale-bench.sh)", scaleReport);
+	cmd.AddValue ("elideMisses","Count worm scans to unassigned addresses instead of sending them", elideMisses);
+	cmd.AddValue ("scanStrategy","Worm target selection, a WormScanStrategy TypeId such as ns3::PermutationScanStrategy", scanStrategy);
+	cmd.AddValue ("transport","Worm transport: udp (sockets) or raw (bare IPv4, WormL4Protocol)", transport);
+	cmd.AddValue ("sharedPayload","Send copies of one template worm packet instead of building every packet", sharedPayload);
+	cmd.AddValue ("connectCount","Scans every infected worm runs at once", connectCount);
 	cmd.Parse (argc, argv);
+	NS_ABORT_MSG_UNLESS (transport == "udp" || transport == "raw", "Unknown --transport=" << transport << ", use udp or raw");
+	std::string wormProtocol = transport == "raw" ? "ns3::WormL4Protocol" : "ns3::UdpSocketFactory";
+	
+	ScaleProbe probe;
+	if (scaleReport) probe.Start ();
+	
+	Config::SetDefault ("ns3::WormApplication::BurstSend", BooleanValue (burstSend));
+	Config::SetDefault ("ns3::WormApplication::ElideMisses", BooleanValue (elideMisses));
+	Config::SetDefault ("ns3::WormApplication::SharedPayload", BooleanValue (sharedPayload));
+	Config::SetDefault ("ns3::WormApplication::ConnectCount", UintegerValue (connectCount));
+	Config::SetDefault ("ns3::WormApplication::ScanStrategy", StringValue (scanStrategy));
+	// the hit list holds the spoke links, indices 0 to nNodes - 1
+	Config::SetDefault ("ns3::HitListScanStrategy::Offset", UintegerValue (0));
+	Config::SetDefault ("ns3::HitListScanStrategy::Size", UintegerValue (nNodes));
 	
 	interval = (double)1 / (scanRate);
 	NS_LOG_INFO("Using worm packet interval of " << interval << "s");
 	
-	if( nNodes > 200 ) nNodes = 200;
-	globalnNodes = nNodes;
-	
 	
 	/*PointToPointHelper bottleneckHelper;
 	bottleneckHelper.SetDeviceAttribute ("DataRate", StringValue ("1Mbps"));
@@ -458,71 +119,99 @@ int main(int argc, char *argv[]) {
 	star.BoundingBox(1,1,100,100);
 	
 	// Create the animation object and configure for specified output
-	AnimationInterface anim ("p4staranim.xml");
-	AnimationInterface *aP = &anim;
-	aP->EnablePacketMetadata (); // Optional
+	AnimationInterface *aP = NULL;
+	if (netanim) {
+		aP = new AnimationInterface ("p4staranim.xml");
+		aP->EnablePacketMetadata ();
+	}
+	
+	Ptr<WormTraceWriter> trace;
+	if (traceFile != "") {
+		trace = CreateObject<WormTraceWriter> ();
+		trace->Open (traceFile);
+	}
 	
 	InternetStackHelper stack;
 	//dumbBell.InstallStack (stack);
 	star.InstallStack(stack);
 	
-	/*Ipv4AddressHelper ipv4L;
-	ipv4L.SetBase ("10.3.1.0", "255.255.255.0");
-	
-	Ipv4AddressHelper ipv4B;
-	ipv4B.SetBase ("10.1.1.0", "255.255.255.0");*/
-	Ipv4AddressHelper ipv4R;
-	ipv4R.SetBase ("10.2.1.0", "255.255.255.0");
-	
 	NS_LOG_INFO ("Assign IP Addresses.");
-	//dumbBell.AssignIpv4Addresses(ipv4L, ipv4R, ipv4B);
-	star.AssignIpv4Addresses(ipv4R);
+	// spoke link i gets the i-th /30, hub first; the hub's devices are
+	// its links in spoke order, the stack's loopback comes after them
+	AddressPlan plan;
+	Ipv4InterfaceContainer spokeInterfaces;
+	for (uint32_t i = 0; i < star.SpokeCount (); ++i) {
+		NetDeviceContainer link;
+		link.Add (star.GetHub ()->GetDevice (i));
+		link.Add (star.GetSpokeNode (i)->GetDevice (0));
+		spokeInterfaces.Add (plan.AssignPointToPoint (link).Get (1));
+	}
 	
 	NS_LOG_INFO ("Create Applications.");
 	
 		
 	
-	ApplicationContainer wormApps[1000];
+	Ptr<InfectionRegistry> registry = CreateObject<InfectionRegistry> ();
+	registry->StopWhenAllInfected (Seconds (0.1));
+	
+	// one target per /30 link handed out above, spoke side; the default
+	// star keeps the original 256 targets
+	uint32_t scanRange = std::max<uint32_t> (256, nNodes);
+	
+	int64_t streamIndex = 0;
+	ApplicationContainer wormApps;
 	for(uint32_t i = 0; i < nNodes; ++i) {
-		WormHelper worm ("ns3::UdpSocketFactory", InetSocketAddress (star.GetSpokeIpv4Address(i), 5001));
-		//NS_LOG_INFO("Making app for address "<<InetSocketAddress (star.GetSpokeIpv4Address(i), 5001));
+		WormHelper worm (wormProtocol, InetSocketAddress (spokeInterfaces.GetAddress (i), 5001));
+		//NS_LOG_INFO("Making app for address "<<InetSocketAddress (spokeInterfaces.GetAddress (i), 5001));
 		if(i == 0){ 
 			worm.SetAttribute("Infected",BooleanValue(true));
-			globalInfectCount++;
 		}
 		worm.SetAttribute("NodeID",UintegerValue(i));
 		worm.SetAttribute("Port",UintegerValue(5001));
 		worm.SetAttribute("Interval",DoubleValue(interval));
 		worm.SetAttribute("Payload",UintegerValue(payload));
-		wormApps[i] = worm.Install (star.GetSpokeNode (i));
-		wormApps[i].Start (Seconds (0.0));
-		wormApps[i].Stop (Seconds (endTime));
+		worm.SetAttribute("InfectThreshold",UintegerValue(payload > 1 ? payload/2 : 1));
+		worm.SetAttribute("ScanNetwork",Ipv4AddressValue("10.0.0.0"));
+		worm.SetAttribute("ScanRange",UintegerValue(scanRange));
+		worm.SetAttribute("ScanStride",UintegerValue(4));
+		ApplicationContainer app = worm.Install (star.GetSpokeNode (i));
+		streamIndex += worm.AssignStreams (star.GetSpokeNode (i), streamIndex);
+		wormApps.Add (app);
 		
-		Ptr<Application>	app;
-		app = wormApps[i].Get(0);
-		app->TraceConnectWithoutContext ( "InfectEvent", MakeCallback (&infectCounter));
 		Ptr<WormApplication> wApp;
-		wApp = DynamicCast<WormApplication> (wormApps[i].Get(0));
+		wApp = DynamicCast<WormApplication> (app.Get(0));
 		wApp->setAnimPoint(aP);
+		wApp->SetTargetIndex (&plan);
+		registry->Track (wApp);
+		if (trace) trace->Track (wApp);
 	}
+	wormApps.Start (Seconds (0.0));
+	wormApps.Stop (Seconds (endTime));
 	
 		
-	//Turn on global static routing
-	Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+	TreeRoutingHelper::Populate (routing, star.GetHub ());
+	
+	if (trace) trace->Start ();
 	
+	probe.SetupDone ();
 	Simulator::Stop (Seconds (endTime));
 	Simulator::Run ();
-	Simulator::Destroy ();
-	
-	double infectCount = 0;
-	Ptr<WormApplication> wApp;
-	
-	
-	for( uint32_t i = 0; i < nNodes; ++i ) {
-		wApp = DynamicCast<WormApplication> (wormApps[i].Get(0));
-		if ( wApp->isInfected() ) {infectCount++;}
+	probe.RunDone ();
+	if (trace) trace->Close ();
+	uint64_t elidedScans = 0, elidedBytes = 0;
+	for (ApplicationContainer::Iterator it = wormApps.Begin (); it != wormApps.End (); ++it) {
+		elidedScans += DynamicCast<WormApplication> (*it)->GetElidedScans ();
+		elidedBytes += DynamicCast<WormApplication> (*it)->GetElidedBytes ();
 	}
-	std::cout << infectCount << " nodes infected."<< std::endl;
+	Simulator::Destroy ();
+	delete aP;
+	
+	std::cout << registry->GetInfectedCount () << " nodes infected."<< std::endl;
+	if (sharedPayload)
+		PayloadTemplate::Print (std::cout);
+	if (elideMisses)
+		std::cout << "Elided " << elidedScans << " scans, " << elidedBytes << " bytes the elided scans would have sent" << std::endl;
+	probe.Print (std::cout, "star");
 
 	
 	NS_LOG_INFO ("Done.");
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Worm transport benchmark: the star at 200, 2000 and 20000 nodes with the
+# UDP socket transport and with the bare IPv4 one (--transport=raw), with
+# --scaleReport's run time, executed events, event rate and peak RSS, and
+# the run time speedup of raw over udp.
+#
+# Run from the ns-3 tree the scenarios are built in:
+#   WAF=./waf sh p4/transport-bench.sh > transport.tsv
+# SIZES and TOPOLOGIES (star, barbell, tree) override the defaults; the
+# tree takes the depth of a 10-ary tree of about that many nodes.
+
+WAF=${WAF:-./waf}
+SIZES=${SIZES:-"200 2000 20000"}
+TOPOLOGIES=${TOPOLOGIES:-"star"}
+
+printf "topology\tnodes\ttransport\trun_s\tevents\tevents_per_s\tpeak_rss_kib\tspeedup\n"
+for topology in $TOPOLOGIES; do
+	for n in $SIZES; do
+		case $topology in
+			star) args="p4_star --nNodes=$n" ;;
+			barbell) args="p4_barbell --nNodes=$((n / 2))" ;;
+			tree) args="p4_tree --depth=$(awk -v n=$n 'BEGIN { print int (log (n) / log (10) + 0.5) }') --fanout=10 --rootFanout=0" ;;
+			*) echo "unknown topology $topology" >&2; exit 1 ;;
+		esac
+		base=""
+		for transport in udp raw; do
+			# Scale <topology> nodes N setup Xs run Ys events E rate R/s peakRss K KiB
+			line=$($WAF --run "$args --transport=$transport --scaleReport=true" 2>/dev/null |
+				awk '$1 == "Scale" { sub (/s$/, "", $8); sub (/\/s$/, "", $12); print $4, $8, $10, $12, $14 }')
+			set -- $line
+			[ $# -eq 5 ] || { printf "%s\t%s\t%s\tfailed\n" $topology $n $transport; continue; }
+			[ -n "$base" ] || base=$2
+			awk -v t=$topology -v tr=$transport -v nodes=$1 -v run=$2 -v ev=$3 -v rate=$4 -v rss=$5 -v base=$base 'BEGIN {
+				printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\t%.2f\n", t, nodes, tr, run, ev, rate, rss, (run > 0 ? base / run : 0) }'
+		done
+	done
+done
@@ -0,0 +1,275 @@
+#include "tree-routing-helper.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TreeRoutingHelper");
+
+namespace {
+
+const uint32_t UNSEEN = 0xffffffff;
+
+long
+ResidentKiB (void)
+{
+  std::ifstream statm ("/proc/self/statm");
+  long size;
+  long resident;
+  if (!(statm >> size >> resident))
+    {
+      return 0;
+    }
+  return resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+double
+WallSeconds (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+} // anonymous namespace
+
+TreeRoutingHelper::TreeRoutingHelper ()
+{
+}
+
+void
+TreeRoutingHelper::Install (Ptr<Node> root) const
+{
+  NS_LOG_FUNCTION (this << root);
+
+  // breadth first order; entry k describes node order[k] and the link to its parent
+  std::vector<Ptr<Node> > order;
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> upInterface;     //!< interface of the node towards its parent
+  std::vector<Ipv4Address> upNextHop;    //!< parent address on that link
+  std::vector<uint32_t> downInterface;   //!< interface of the parent towards the node
+  std::vector<Ipv4Address> downNextHop;  //!< node address on that link
+  std::vector<Ranges> ranges;            //!< subnets at and below the parent link
+  std::vector<uint32_t> index (NodeList::GetNNodes (), UNSEEN);
+
+  index[root->GetId ()] = 0;
+  order.push_back (root);
+  parent.push_back (UNSEEN);
+  upInterface.push_back (0);
+  upNextHop.push_back (Ipv4Address ());
+  downInterface.push_back (0);
+  downNextHop.push_back (Ipv4Address ());
+  ranges.push_back (Ranges ());
+
+  for (uint32_t k = 0; k < order.size (); k++)
+    {
+      Ptr<Node> node = order[k];
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ABORT_MSG_IF (ipv4 == 0, "Node " << node->GetId () << " has no IPv4 stack");
+      for (uint32_t d = 0; d < node->GetNDevices (); d++)
+        {
+          Ptr<NetDevice> device = node->GetDevice (d);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (DynamicCast<PointToPointChannel> (channel) == 0 || channel->GetNDevices () != 2)
+            {
+              continue;
+            }
+          Ptr<NetDevice> peerDevice = channel->GetDevice (channel->GetDevice (0) == device ? 1 : 0);
+          Ptr<Node> peer = peerDevice->GetNode ();
+          if (index[peer->GetId ()] == parent[k])
+            {
+              continue;
+            }
+          NS_ABORT_MSG_IF (index[peer->GetId ()] != UNSEEN,
+                           "Links below node " << root->GetId () << " are not a tree");
+
+          Ptr<Ipv4> peerIpv4 = peer->GetObject<Ipv4> ();
+          NS_ABORT_MSG_IF (peerIpv4 == 0, "Node " << peer->GetId () << " has no IPv4 stack");
+          int32_t here = ipv4->GetInterfaceForDevice (device);
+          int32_t there = peerIpv4->GetInterfaceForDevice (peerDevice);
+          if (here < 0 || there < 0 || ipv4->GetNAddresses (here) == 0 || peerIpv4->GetNAddresses (there) == 0)
+            {
+              continue;
+            }
+          Ipv4InterfaceAddress peerAddress = peerIpv4->GetAddress (there, 0);
+          uint32_t mask = peerAddress.GetMask ().Get ();
+          uint32_t network = peerAddress.GetLocal ().Get () & mask;
+
+          index[peer->GetId ()] = order.size ();
+          order.push_back (peer);
+          parent.push_back (k);
+          upInterface.push_back (there);
+          upNextHop.push_back (ipv4->GetAddress (here, 0).GetLocal ());
+          downInterface.push_back (here);
+          downNextHop.push_back (peerAddress.GetLocal ());
+          ranges.push_back (Ranges (1, std::make_pair (network, network | ~mask)));
+        }
+    }
+
+  // children come after their parent, so walking backwards sees every subtree complete
+  uint32_t routes = 0;
+  for (uint32_t k = order.size () - 1; k > 0; k--)
+    {
+      Merge (ranges[k]);
+      routes += AddRoutes (order[parent[k]], ranges[k], downNextHop[k], downInterface[k]);
+      ranges[parent[k]].insert (ranges[parent[k]].end (), ranges[k].begin (), ranges[k].end ());
+      Ranges ().swap (ranges[k]);
+    }
+  Merge (ranges[0]);
+  if (ranges[0].empty ())
+    {
+      NS_LOG_INFO ("No links below node " << root->GetId ());
+      return;
+    }
+
+  // one route up: the smallest prefix that holds every subnet of the tree
+  uint32_t first = ranges[0].front ().first;
+  uint32_t last = ranges[0].back ().second;
+  uint32_t mask = 0xffffffff;
+  while ((first & mask) != (last & mask))
+    {
+      mask <<= 1;
+    }
+  Ranges aggregate (1, std::make_pair (first & mask, (first & mask) | ~mask));
+  for (uint32_t k = 1; k < order.size (); k++)
+    {
+      routes += AddRoutes (order[k], aggregate, upNextHop[k], upInterface[k]);
+    }
+
+  NS_LOG_INFO ("Installed " << routes << " routes on " << order.size () << " nodes");
+}
+
+void
+TreeRoutingHelper::Merge (Ranges &ranges)
+{
+  if (ranges.empty ())
+    {
+      return;
+    }
+  std::sort (ranges.begin (), ranges.end ());
+  uint32_t last = 0;
+  for (uint32_t i = 1; i < ranges.size (); i++)
+    {
+      if (uint64_t (ranges[i].first) <= uint64_t (ranges[last].second) + 1)
+        {
+          ranges[last].second = std::max (ranges[last].second, ranges[i].second);
+        }
+      else
+        {
+          ranges[++last] = ranges[i];
+        }
+    }
+  ranges.resize (last + 1);
+}
+
+uint32_t
+TreeRoutingHelper::AddRoutes (Ptr<Node> node, const Ranges &ranges, Ipv4Address nextHop, uint32_t interface)
+{
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (node->GetObject<Ipv4> ());
+  uint32_t routes = 0;
+  for (uint32_t i = 0; i < ranges.size (); i++)
+    {
+      // split the range into the largest aligned prefixes it contains
+      uint64_t first = ranges[i].first;
+      uint64_t last = ranges[i].second;
+      while (first <= last)
+        {
+          uint64_t size = first == 0 ? uint64_t (1) << 32 : first & (~first + 1);
+          while (size > last - first + 1)
+            {
+              size >>= 1;
+            }
+          uint32_t mask = size == uint64_t (1) << 32 ? 0 : ~uint32_t (size - 1);
+          routing->AddNetworkRouteTo (Ipv4Address (uint32_t (first)), Ipv4Mask (mask), nextHop, interface);
+          routes++;
+          first += size;
+        }
+    }
+  return routes;
+}
+
+uint32_t
+TreeRoutingHelper::GetNRoutes (NodeContainer c)
+{
+  uint32_t routes = 0;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+      if (list == 0)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < list->GetNRoutingProtocols (); j++)
+        {
+          int16_t priority;
+          Ptr<Ipv4RoutingProtocol> protocol = list->GetRoutingProtocol (j, priority);
+          Ptr<Ipv4StaticRouting> staticRouting = DynamicCast<Ipv4StaticRouting> (protocol);
+          Ptr<Ipv4GlobalRouting> globalRouting = DynamicCast<Ipv4GlobalRouting> (protocol);
+          if (staticRouting != 0)
+            {
+              routes += staticRouting->GetNRoutes ();
+            }
+          else if (globalRouting != 0)
+            {
+              routes += globalRouting->GetNRoutes ();
+            }
+        }
+    }
+  return routes;
+}
+
+void
+TreeRoutingHelper::Populate (std::string routing, Ptr<Node> root)
+{
+  long residentBefore = ResidentKiB ();
+  double start = WallSeconds ();
+
+  if (routing == "global")
+    {
+      Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    }
+  else if (routing == "tree")
+    {
+      TreeRoutingHelper ().Install (root);
+    }
+  else
+    {
+      NS_ABORT_MSG ("Unknown routing \"" << routing << "\", use global or tree");
+    }
+
+  double elapsed = WallSeconds () - start;
+  uint32_t routes = GetNRoutes (NodeContainer::GetGlobal ());
+  // entry plus the std::list node that holds it in either protocol
+  uint64_t routeBytes = uint64_t (routes) * (sizeof (Ipv4RoutingTableEntry) + 4 * sizeof (void *));
+
+  std::cout << "Routing setup (" << routing << "): " << elapsed << "s, "
+            << routes << " routes (~" << routeBytes / 1024 << " KiB), resident set +"
+            << ResidentKiB () - residentBefore << " KiB" << std::endl;
+}
+
+} // namespace ns3
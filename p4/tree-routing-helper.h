@@ -0,0 +1,71 @@
+#ifndef TREE_ROUTING_HELPER_H
+#define TREE_ROUTING_HELPER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "ns3/ptr.h"
+#include "ns3/node-container.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * Static routes for topologies whose point-to-point links form a tree,
+ * such as the star, dumbbell and TreeTopologyHelper layouts.
+ *
+ * A breadth first walk from the root finds the parent link of every node.
+ * Walking back up, the subnets below each node are merged into address
+ * ranges and the parent gets one route per aligned prefix of those ranges
+ * towards the child.  Every node but the root gets a single route up: the
+ * smallest prefix that holds every subnet of the tree, towards its parent.
+ * The up routes are N - 1; the down routes depend on how the addresses
+ * follow the tree.  The p4 helpers hand out /30s in breadth first link
+ * order, so a subtree is one range per level below it, and the down routes
+ * come to about 1.3 per link (203 for the 125-node default tree, 14707 for
+ * the 11111-node 10-ary tree of depth 4), against the all-pairs shortest
+ * path run of Ipv4GlobalRoutingHelper.
+ *
+ * A packet for an address inside the aggregate that no subnet holds, such
+ * as a worm scan of an unused /30, climbs to the root and is dropped
+ * there, where global routing drops it at the sender; addresses outside
+ * the aggregate are still dropped at the sender.  Routes go into the
+ * Ipv4StaticRouting of each node.
+ */
+class TreeRoutingHelper
+{
+public:
+  TreeRoutingHelper ();
+
+  /**
+   * Install the routes of every node reachable from root.  Aborts if the
+   * links below root contain a cycle.
+   */
+  void Install (Ptr<Node> root) const;
+
+  /**
+   * \return the number of static and global routes held by the nodes
+   */
+  static uint32_t GetNRoutes (NodeContainer c);
+
+  /**
+   * Fill the routing tables with the "global" (Ipv4GlobalRoutingHelper)
+   * or "tree" (this helper, rooted at root) method and print the wall
+   * time, the route count, their approximate size and the growth of the
+   * resident set.
+   */
+  static void Populate (std::string routing, Ptr<Node> root);
+
+private:
+  typedef std::vector<std::pair<uint32_t, uint32_t> > Ranges; //!< sorted, disjoint [first, last] address ranges
+
+  static void Merge (Ranges &ranges);
+  static uint32_t AddRoutes (Ptr<Node> node, const Ranges &ranges, Ipv4Address nextHop, uint32_t interface);
+};
+
+} // namespace ns3
+
+#endif /* TREE_ROUTING_HELPER_H */
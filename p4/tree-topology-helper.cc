@@ -0,0 +1,215 @@
+#include "tree-topology-helper.h"
+#include "../common/address-plan.h"
+
+#include <cmath>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/constant-position-mobility-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TreeTopologyHelper");
+
+TreeTopologyHelper::TreeTopologyHelper (uint32_t depth, uint32_t fanout, PointToPointHelper link, uint32_t systems)
+  : m_fanouts (depth, fanout),
+    m_systems (systems)
+{
+  Build (link);
+}
+
+TreeTopologyHelper::TreeTopologyHelper (std::vector<uint32_t> fanouts, PointToPointHelper link, uint32_t systems)
+  : m_fanouts (fanouts),
+    m_systems (systems)
+{
+  Build (link);
+}
+
+TreeTopologyHelper::~TreeTopologyHelper ()
+{
+}
+
+void
+TreeTopologyHelper::Build (PointToPointHelper link)
+{
+  uint64_t levelNodes = 1;
+  uint64_t total = 1;
+  m_levelOffsets.push_back (0);
+  for (uint32_t l = 0; l < m_fanouts.size (); l++)
+    {
+      NS_ABORT_MSG_IF (m_fanouts[l] == 0, "Tree level " << l << " has no children");
+      m_levelOffsets.push_back (total);
+      levelNodes *= m_fanouts[l];
+      total += levelNodes;
+      NS_ABORT_MSG_IF (total > 0xffffffff, "Tree is too large");
+    }
+  m_levelOffsets.push_back (total);
+  NS_LOG_INFO ("Building a tree of " << total << " nodes and " << levelNodes << " leaves");
+
+  NS_ABORT_MSG_IF (m_systems == 0, "A tree needs at least one system");
+  if (m_systems == 1)
+    {
+      m_nodes.Create (total);
+    }
+  else
+    {
+      for (uint32_t l = 0; l <= m_fanouts.size (); l++)
+        {
+          for (uint32_t j = 0; j < GetNLevelNodes (l); j++)
+            {
+              m_nodes.Add (CreateObject<Node> (GetSystemId (l, j)));
+            }
+        }
+    }
+  for (uint32_t l = 1; l <= m_fanouts.size (); l++)
+    {
+      for (uint32_t j = 0; j < GetNLevelNodes (l); j++)
+        {
+          Ptr<Node> parent = GetNode (l - 1, j / m_fanouts[l - 1]);
+          m_devices.Add (link.Install (parent, GetNode (l, j)));
+        }
+    }
+}
+
+uint32_t
+TreeTopologyHelper::GetIndex (uint32_t level, uint32_t index) const
+{
+  NS_ASSERT (level <= m_fanouts.size ());
+  NS_ASSERT (index < GetNLevelNodes (level));
+  return m_levelOffsets[level] + index;
+}
+
+uint32_t
+TreeTopologyHelper::GetDepth (void) const
+{
+  return m_fanouts.size ();
+}
+
+uint32_t
+TreeTopologyHelper::GetNNodes (void) const
+{
+  return m_nodes.GetN ();
+}
+
+uint32_t
+TreeTopologyHelper::GetNLinks (void) const
+{
+  return m_nodes.GetN () - 1;
+}
+
+uint32_t
+TreeTopologyHelper::GetNLevelNodes (uint32_t level) const
+{
+  return m_levelOffsets[level + 1] - m_levelOffsets[level];
+}
+
+uint32_t
+TreeTopologyHelper::GetNLeaves (void) const
+{
+  return GetNLevelNodes (GetDepth ());
+}
+
+uint32_t
+TreeTopologyHelper::GetSystemId (uint32_t level, uint32_t index) const
+{
+  uint32_t split = 1;
+  while (split < GetDepth () && GetNLevelNodes (split) < m_systems)
+    {
+      split++;
+    }
+  if (level < split || m_systems == 1)
+    {
+      return 0;
+    }
+  // levels are contiguous, so the ancestor on the split level is a division away
+  uint64_t ancestor = index / (GetNLevelNodes (level) / GetNLevelNodes (split));
+  return ancestor * m_systems / GetNLevelNodes (split);
+}
+
+Ptr<Node>
+TreeTopologyHelper::GetRoot (void) const
+{
+  return m_nodes.Get (0);
+}
+
+Ptr<Node>
+TreeTopologyHelper::GetNode (uint32_t level, uint32_t index) const
+{
+  return m_nodes.Get (GetIndex (level, index));
+}
+
+Ptr<Node>
+TreeTopologyHelper::GetLeaf (uint32_t index) const
+{
+  return GetNode (GetDepth (), index);
+}
+
+NodeContainer
+TreeTopologyHelper::GetNodes (void) const
+{
+  return m_nodes;
+}
+
+Ipv4Address
+TreeTopologyHelper::GetAddress (uint32_t level, uint32_t index) const
+{
+  NS_ASSERT (level > 0);
+  uint32_t linkId = GetIndex (level, index) - 1;
+  return m_interfaces.GetAddress (2 * linkId + 1);
+}
+
+Ipv4Address
+TreeTopologyHelper::GetLeafAddress (uint32_t index) const
+{
+  return GetAddress (GetDepth (), index);
+}
+
+void
+TreeTopologyHelper::InstallStack (InternetStackHelper stack)
+{
+  stack.Install (m_nodes);
+}
+
+void
+TreeTopologyHelper::AssignIpv4Addresses (AddressPlan &plan)
+{
+  for (uint32_t linkId = 0; linkId < GetNLinks (); linkId++)
+    {
+      NetDeviceContainer pair;
+      pair.Add (m_devices.Get (2 * linkId));
+      pair.Add (m_devices.Get (2 * linkId + 1));
+      m_interfaces.Add (plan.AssignPointToPoint (pair));
+    }
+}
+
+void
+TreeTopologyHelper::BoundingBox (double ulx, double uly, double lrx, double lry)
+{
+  double cx = (ulx + lrx) / 2;
+  double cy = (uly + lry) / 2;
+  double rx = (lrx - ulx) / 2;
+  double ry = (lry - uly) / 2;
+
+  for (uint32_t l = 0; l <= GetDepth (); l++)
+    {
+      double radius = GetDepth () == 0 ? 0 : double (l) / GetDepth ();
+      uint32_t n = GetNLevelNodes (l);
+      for (uint32_t j = 0; j < n; j++)
+        {
+          double angle = 2 * M_PI * (j + 0.5) / n;
+          Ptr<Node> node = GetNode (l, j);
+          Ptr<ConstantPositionMobilityModel> loc = node->GetObject<ConstantPositionMobilityModel> ();
+          if (loc == 0)
+            {
+              loc = CreateObject<ConstantPositionMobilityModel> ();
+              node->AggregateObject (loc);
+            }
+          loc->SetPosition (Vector (cx + rx * radius * std::cos (angle),
+                                    cy + ry * radius * std::sin (angle), 0));
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,123 @@
+#ifndef TREE_TOPOLOGY_HELPER_H
+#define TREE_TOPOLOGY_HELPER_H
+
+#include <vector>
+
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/point-to-point-helper.h"
+
+namespace ns3 {
+
+class AddressPlan;
+
+/**
+ * Builds a rooted tree of point-to-point links.
+ *
+ * Level 0 is the root and level depth holds the leaves; every node of
+ * level l has fanout(l) children.  Nodes live in one NodeContainer in
+ * breadth first order, so the children of a node, the nodes of a level and
+ * the leaves are contiguous.  Link i joins node i + 1 to its parent; its
+ * devices are entries 2i (parent side) and 2i + 1 (child side) of one
+ * NetDeviceContainer, and its interfaces the same entries of one
+ * Ipv4InterfaceContainer.  Leaf links are therefore the last ones and get
+ * the last, consecutive /30s.
+ *
+ * Construction, address assignment and layout are linear in the number of
+ * nodes.
+ *
+ * For distributed runs the nodes are spread over systems (MPI ranks) by
+ * subtree: the first level with at least as many nodes as there are
+ * systems is split into contiguous blocks, every node below follows its
+ * ancestor on that level and the levels above stay on system 0.
+ */
+class TreeTopologyHelper
+{
+public:
+  /**
+   * Create a tree where every non-leaf node has the same number of children.
+   *
+   * \param depth number of levels below the root
+   * \param fanout children per non-leaf node
+   * \param link helper used to install every link
+   * \param systems number of systems the nodes are spread over
+   */
+  TreeTopologyHelper (uint32_t depth, uint32_t fanout, PointToPointHelper link, uint32_t systems = 1);
+
+  /**
+   * Create a tree with a different number of children per level.
+   *
+   * \param fanouts children per node of level 0, 1, ...; the tree has
+   * fanouts.size () levels below the root
+   * \param link helper used to install every link
+   * \param systems number of systems the nodes are spread over
+   */
+  TreeTopologyHelper (std::vector<uint32_t> fanouts, PointToPointHelper link, uint32_t systems = 1);
+
+  ~TreeTopologyHelper ();
+
+  uint32_t GetDepth (void) const;
+  uint32_t GetNNodes (void) const;
+  uint32_t GetNLinks (void) const;
+  uint32_t GetNLevelNodes (uint32_t level) const;
+  uint32_t GetNLeaves (void) const;
+
+  /**
+   * \return the system (MPI rank) the node was created on
+   */
+  uint32_t GetSystemId (uint32_t level, uint32_t index) const;
+
+  Ptr<Node> GetRoot (void) const;
+  Ptr<Node> GetNode (uint32_t level, uint32_t index) const;
+  Ptr<Node> GetLeaf (uint32_t index) const;
+
+  /**
+   * \return every node, in breadth first order
+   */
+  NodeContainer GetNodes (void) const;
+
+  /**
+   * \return the address of a non-root node on the link to its parent
+   */
+  Ipv4Address GetAddress (uint32_t level, uint32_t index) const;
+
+  /**
+   * \return the address of a leaf on the link to its parent
+   */
+  Ipv4Address GetLeafAddress (uint32_t index) const;
+
+  /**
+   * \param stack helper used to install the stack on every node
+   */
+  void InstallStack (InternetStackHelper stack);
+
+  /**
+   * Give every link its own /30 from the plan, in link order: the parent
+   * gets the first address and the child the second one.
+   */
+  void AssignIpv4Addresses (AddressPlan &plan);
+
+  /**
+   * Place the nodes on concentric rings inside the given box: the root in
+   * the centre, level l on the ring of radius l / depth, and every node
+   * at the angle in the middle of its own leaves.
+   */
+  void BoundingBox (double ulx, double uly, double lrx, double lry);
+
+private:
+  void Build (PointToPointHelper link);
+  uint32_t GetIndex (uint32_t level, uint32_t index) const;
+
+  std::vector<uint32_t> m_fanouts;
+  uint32_t m_systems;
+  std::vector<uint32_t> m_levelOffsets;  //!< index of the first node of each level, plus the total
+  NodeContainer m_nodes;
+  NetDeviceContainer m_devices;
+  Ipv4InterfaceContainer m_interfaces;
+};
+
+} // namespace ns3
+
+#endif /* TREE_TOPOLOGY_HELPER_H */
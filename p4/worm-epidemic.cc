@@ -0,0 +1,411 @@
+// Host/flow-level epidemic engine for the p4 worm, for populations the
+// packet-level WormApplication cannot reach (10^6 hosts in seconds).
+//
+// Usage: worm-epidemic [-n hosts] [-s scanRate] [-p payload] [-T threshold]
+//                      [-R scanRange] [-H hops] [-d delay] [-b bitRate]
+//                      [-l loss] [-e endTime] [-r run] [-q]
+//        worm-epidemic -c packet-run.txt [-c ...] [-N replications] [other options]
+//
+// The rules are WormApplication's: every infected host scans one target
+// per 1/scanRate seconds, uniformly among ScanRange /30 links of 10.0.0.0/8
+// (10.0.0.0 + 4 k + 2 for link k, as p4_star lays out its spokes), sending
+// a train of Payload packets spread over the scan interval.  A host is
+// infected by the packet that takes its received count past InfectThreshold
+// (m_packsRec >= threshold) and starts scanning at once; host 0 is the seed.
+// Link k holds host k for k < hosts, every other scan misses.  10.0.0.0/8
+// holds 2^22 such links, which bounds -n (and the default ScanRange).
+//
+// Instead of packets and sockets the engine keeps one counter per host and
+// one event per scan that lands on a host: the misses before each hit are
+// skipped with a single geometric draw.  The network is abstracted to a
+// path of -H hops (2 for the star) of -d seconds and -b bit/s each, which
+// sets the train's arrival time and stretches its spacing when the access
+// link cannot carry it, and to an independent per-packet loss -l.  The
+// defaults match p4_star.  Output is the packet run's infection curve,
+// "Node i infected at Ts by a.b.c.d" lines and "N nodes infected.".
+//
+// Calibration (-c, repeatable): read the infection lines of packet-level
+// runs of the same scenario, then search loss and an extra path delay for
+// the pair whose mean curve over -N replications (default 20) is closest,
+// as the RMS difference of the k-th infection times.  The fitted values
+// are what to pass with -l and -d for the large runs.
+// Standalone: it does not link against ns-3.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+struct Scenario
+{
+  uint32_t hosts;
+  double scanRate;
+  uint32_t payload;
+  uint32_t threshold;
+  uint32_t scanRange;
+  uint32_t hops;
+  double delay;       //!< per hop, seconds
+  double bitRate;     //!< per hop, bit/s
+  double loss;        //!< per packet
+  double endTime;
+};
+
+enum EventType
+{
+  SCAN = 0,           //!< a scan of host lands on another host
+  INFECT = 1          //!< host becomes infected by from
+};
+
+struct Event
+{
+  double time;
+  uint32_t host;
+  uint32_t from;
+  uint32_t type;
+
+  bool operator> (const Event &other) const
+  {
+    return time > other.time;
+  }
+};
+
+// xorshift64*, seeded through splitmix64 so neighbouring runs differ
+class Random
+{
+public:
+  explicit Random (uint64_t seed)
+  {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    m_state = (z ^ (z >> 31)) | 1;
+  }
+
+  uint64_t Next (void)
+  {
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return m_state * 0x2545f4914f6cdd1dULL;
+  }
+
+  // uniform in (0, 1)
+  double Uniform (void)
+  {
+    return ((Next () >> 11) + 0.5) / 9007199254740992.0;
+  }
+
+  // uniform in [0, n)
+  uint32_t Integer (uint32_t n)
+  {
+    return (uint32_t) (Uniform () * n);
+  }
+
+private:
+  uint64_t m_state;
+};
+
+// the /30 links of 10.0.0.0/8, the most hosts Address () can name
+const uint32_t MAX_HOSTS = 1u << 22;
+
+// WormApplication's address for link k: ScanNetwork 10.0.0.0 + k * 4 + ScanHost 2,
+// the 22 bits of k above the 2 bits of the host within its /30
+std::string
+Address (uint32_t host)
+{
+  uint32_t address = (10u << 24) + host * 4 + 2;
+  char text[16];
+  std::sprintf (text, "%u.%u.%u.%u", address >> 24, (address >> 16) & 0xff, (address >> 8) & 0xff, address & 0xff);
+  return text;
+}
+
+typedef std::priority_queue<Event, std::vector<Event>, std::greater<Event> > EventQueue;
+
+// queue the first scan of host at or after time that lands on another host
+void
+ScheduleScan (EventQueue &events, Random &rng, double hit, double interval, double endTime,
+              uint32_t host, double time)
+{
+  if (hit <= 0)
+    {
+      return;
+    }
+  // the misses in between are a geometric number of scan intervals
+  double misses = hit < 1 ? std::floor (std::log (rng.Uniform ()) / std::log (1 - hit)) : 0;
+  Event e;
+  e.time = time + misses * interval;
+  e.host = host;
+  e.from = host;
+  e.type = SCAN;
+  if (e.time < endTime)
+    {
+      events.push (e);
+    }
+}
+
+/**
+ * Run one replication; fills times with the infection time of every host
+ * other than the seed, in order, and returns the number of events.
+ */
+uint64_t
+Simulate (const Scenario &s, uint64_t run, bool print, std::vector<double> &times)
+{
+  Random rng (run);
+  double interval = 1.0 / s.scanRate;
+  double wire = (32 + 8 + 20 + 2) * 8.0;
+  // packets of a train leave interval / payload apart unless the link is slower
+  double spacing = std::max (interval / s.payload, wire / s.bitRate);
+  double latency = s.hops * (s.delay + wire / s.bitRate);
+  // a worm never scans itself: each scan lands on another host with probability
+  double hit = s.hosts > 1 ? (double) (s.hosts - 1) / (std::max (s.scanRange, s.hosts) - 1) : 0;
+
+  std::vector<uint32_t> received (s.hosts, 0);
+  std::vector<bool> infected (s.hosts, false);
+  EventQueue events;
+  uint64_t processed = 0;
+  times.clear ();
+
+  infected[0] = true;
+  ScheduleScan (events, rng, hit, interval, s.endTime, 0, 0);
+  while (!events.empty ())
+    {
+      Event e = events.top ();
+      events.pop ();
+      processed++;
+      if (e.type == INFECT)
+        {
+          if (infected[e.host])
+            {
+              continue;
+            }
+          infected[e.host] = true;
+          times.push_back (e.time);
+          if (print)
+            {
+              std::cout << "Node " << e.host << " infected at " << e.time << "s by " << Address (e.from) << "\n";
+            }
+          if (times.size () + 1 == s.hosts)
+            {
+              break;
+            }
+          ScheduleScan (events, rng, hit, interval, s.endTime, e.host, e.time);
+          continue;
+        }
+
+      uint32_t target = rng.Integer (s.hosts - 1);
+      if (target >= e.host)
+        {
+          target++;
+        }
+      // count the train's packets in; the one that crosses the threshold infects
+      if (!infected[target])
+        {
+          for (uint32_t k = 0; k < s.payload; k++)
+            {
+              if (s.loss > 0 && rng.Uniform () < s.loss)
+                {
+                  continue;
+                }
+              if (received[target]++ >= s.threshold)
+                {
+                  Event infect;
+                  infect.time = e.time + latency + k * spacing;
+                  infect.host = target;
+                  infect.from = e.host;
+                  infect.type = INFECT;
+                  if (infect.time < s.endTime)
+                    {
+                      events.push (infect);
+                    }
+                  break;
+                }
+            }
+        }
+      ScheduleScan (events, rng, hit, interval, s.endTime, e.host, e.time + interval);
+    }
+  return processed;
+}
+
+// infection times of a packet-level run, read from its "Node i infected at Ts" lines
+bool
+ReadCurve (const char *name, std::vector<double> &times)
+{
+  std::ifstream in (name);
+  if (!in)
+    {
+      return false;
+    }
+  std::string line;
+  while (std::getline (in, line))
+    {
+      unsigned node;
+      double time;
+      if (std::sscanf (line.c_str (), "Node %u infected at %lfs", &node, &time) == 2)
+        {
+          times.push_back (time);
+        }
+    }
+  std::sort (times.begin (), times.end ());
+  return true;
+}
+
+// RMS difference of the k-th infection times; infections that never
+// happened count as happening at the end of the run
+double
+Distance (const std::vector<double> &a, const std::vector<double> &b, uint32_t points, double endTime)
+{
+  double sum = 0;
+  for (uint32_t k = 0; k < points; k++)
+    {
+      double x = k < a.size () ? a[k] : endTime;
+      double y = k < b.size () ? b[k] : endTime;
+      sum += (x - y) * (x - y);
+    }
+  return points > 0 ? std::sqrt (sum / points) : 0;
+}
+
+// mean k-th infection time over runs, for k up to points
+std::vector<double>
+MeanCurve (const std::vector<std::vector<double> > &runs, uint32_t points, double endTime)
+{
+  std::vector<double> mean (points, 0);
+  for (uint32_t k = 0; k < points; k++)
+    {
+      for (size_t r = 0; r < runs.size (); r++)
+        {
+          mean[k] += k < runs[r].size () ? runs[r][k] : endTime;
+        }
+      mean[k] /= runs.size ();
+    }
+  return mean;
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  Scenario s;
+  s.hosts = 50;
+  s.scanRate = 10;
+  s.payload = 10;
+  s.threshold = 5;
+  s.scanRange = 0;
+  s.hops = 2;
+  s.delay = 0.020;
+  s.bitRate = 1e6;
+  s.loss = 0;
+  s.endTime = 10;
+  uint64_t run = 1;
+  bool quiet = false;
+  uint32_t replications = 20;
+  std::vector<const char *> curves;
+  int option;
+  while ((option = getopt (argc, argv, "n:s:p:T:R:H:d:b:l:e:r:qc:N:")) != -1)
+    {
+      switch (option)
+        {
+        case 'n': s.hosts = std::strtoul (optarg, 0, 10); break;
+        case 's': s.scanRate = std::atof (optarg); break;
+        case 'p': s.payload = std::strtoul (optarg, 0, 10); break;
+        case 'T': s.threshold = std::strtoul (optarg, 0, 10); break;
+        case 'R': s.scanRange = std::strtoul (optarg, 0, 10); break;
+        case 'H': s.hops = std::strtoul (optarg, 0, 10); break;
+        case 'd': s.delay = std::atof (optarg); break;
+        case 'b': s.bitRate = std::atof (optarg); break;
+        case 'l': s.loss = std::atof (optarg); break;
+        case 'e': s.endTime = std::atof (optarg); break;
+        case 'r': run = std::strtoull (optarg, 0, 10); break;
+        case 'q': quiet = true; break;
+        case 'c': curves.push_back (optarg); break;
+        case 'N': replications = std::strtoul (optarg, 0, 10); break;
+        default:
+          optind = argc + 1;
+        }
+    }
+  if (optind != argc || s.hosts < 1 || s.scanRate <= 0 || s.payload < 1 || s.bitRate <= 0
+      || s.loss < 0 || s.loss >= 1 || replications < 1)
+    {
+      std::cerr << "Usage: " << argv[0] << " [-n hosts] [-s scanRate] [-p payload] [-T threshold]"
+                << " [-R scanRange] [-H hops] [-d delay] [-b bitRate] [-l loss] [-e endTime] [-r run] [-q]"
+                << " [-c packet-run.txt ... -N replications]" << std::endl;
+      return 1;
+    }
+  if (s.hosts > MAX_HOSTS)
+    {
+      std::cerr << "At most " << MAX_HOSTS << " hosts fit one /30 each in 10.0.0.0/8" << std::endl;
+      return 1;
+    }
+  // as p4_star: every spoke link, and at least 256 of them
+  if (s.scanRange == 0)
+    {
+      s.scanRange = std::max<uint32_t> (256, s.hosts);
+    }
+
+  if (curves.empty ())
+    {
+      struct timeval begin, end;
+      gettimeofday (&begin, 0);
+      std::vector<double> times;
+      uint64_t events = Simulate (s, run, !quiet, times);
+      gettimeofday (&end, 0);
+      std::cout << times.size () + 1 << " nodes infected." << std::endl;
+      std::cerr << "hosts " << s.hosts << " events " << events << " wall "
+                << (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1e6 << "s" << std::endl;
+      return 0;
+    }
+
+  std::vector<std::vector<double> > packetRuns (curves.size ());
+  uint32_t points = 0;
+  for (size_t i = 0; i < curves.size (); i++)
+    {
+      if (!ReadCurve (curves[i], packetRuns[i]))
+        {
+          std::cerr << "Cannot read " << curves[i] << std::endl;
+          return 1;
+        }
+      points = std::max<uint32_t> (points, packetRuns[i].size ());
+    }
+  points = std::min (points, s.hosts - 1);
+  std::vector<double> target = MeanCurve (packetRuns, points, s.endTime);
+
+  double bestLoss = 0, bestDelay = 0, bestDistance = HUGE_VAL;
+  double baseDelay = s.delay;
+  for (uint32_t l = 0; l < 19; l++)
+    {
+      for (uint32_t d = 0; d < 11; d++)
+        {
+          Scenario trial = s;
+          trial.loss = l * 0.05;
+          trial.delay = baseDelay + d * 0.010;
+          std::vector<std::vector<double> > runs (replications);
+          for (uint32_t r = 0; r < replications; r++)
+            {
+              Simulate (trial, run + r, false, runs[r]);
+            }
+          double distance = Distance (MeanCurve (runs, points, s.endTime), target, points, s.endTime);
+          if (distance < bestDistance)
+            {
+              bestDistance = distance;
+              bestLoss = trial.loss;
+              bestDelay = trial.delay;
+            }
+        }
+    }
+  std::cout << "calibrated over " << curves.size () << " packet runs, " << points << " infections: loss "
+            << bestLoss << " delay " << bestDelay << " rms " << bestDistance << "s" << std::endl;
+  std::cout << "use: -l " << bestLoss << " -d " << bestDelay << std::endl;
+  return 0;
+}
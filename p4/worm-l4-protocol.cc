@@ -0,0 +1,134 @@
+#include "worm-l4-protocol.h"
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv6-header.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WormL4Protocol");
+
+NS_OBJECT_ENSURE_REGISTERED (WormL4Protocol);
+
+const uint8_t WormL4Protocol::PROT_NUMBER = 253;
+
+TypeId
+WormL4Protocol::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WormL4Protocol")
+    .SetParent<IpL4Protocol> ()
+    .AddConstructor<WormL4Protocol> ()
+  ;
+  return tid;
+}
+
+WormL4Protocol::WormL4Protocol ()
+  : m_node (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WormL4Protocol::~WormL4Protocol ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WormL4Protocol::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_node = 0;
+  m_rxCallback = MakeNullCallback<void, Ptr<Packet>, Ipv4Address> ();
+  m_downTarget.Nullify ();
+  m_downTarget6.Nullify ();
+  IpL4Protocol::DoDispose ();
+}
+
+void
+WormL4Protocol::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_node == 0)
+    {
+      Ptr<Node> node = GetObject<Node> ();
+      if (node != 0)
+        {
+          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+          if (ipv4 != 0 && m_downTarget.IsNull ())
+            {
+              m_node = node;
+              ipv4->Insert (this);
+            }
+        }
+    }
+  IpL4Protocol::NotifyNewAggregate ();
+}
+
+void
+WormL4Protocol::SetReceiveCallback (Callback<void, Ptr<Packet>, Ipv4Address> callback)
+{
+  m_rxCallback = callback;
+}
+
+void
+WormL4Protocol::Send (Ptr<Packet> packet, Ipv4Address source, Ipv4Address destination)
+{
+  NS_LOG_FUNCTION (this << packet << source << destination);
+  m_downTarget (packet, source, destination, PROT_NUMBER, 0);
+}
+
+int
+WormL4Protocol::GetProtocolNumber (void) const
+{
+  return PROT_NUMBER;
+}
+
+enum IpL4Protocol::RxStatus
+WormL4Protocol::Receive (Ptr<Packet> p, Ipv4Header const &header, Ptr<Ipv4Interface> incomingInterface)
+{
+  NS_LOG_FUNCTION (this << p << header.GetSource ());
+  if (m_rxCallback.IsNull ())
+    {
+      return IpL4Protocol::RX_ENDPOINT_UNREACH;
+    }
+  m_rxCallback (p, header.GetSource ());
+  return IpL4Protocol::RX_OK;
+}
+
+enum IpL4Protocol::RxStatus
+WormL4Protocol::Receive (Ptr<Packet> p, Ipv6Header const &header, Ptr<Ipv6Interface> incomingInterface)
+{
+  // the worm only scans IPv4
+  return IpL4Protocol::RX_ENDPOINT_UNREACH;
+}
+
+void
+WormL4Protocol::SetDownTarget (IpL4Protocol::DownTargetCallback cb)
+{
+  m_downTarget = cb;
+}
+
+void
+WormL4Protocol::SetDownTarget6 (IpL4Protocol::DownTargetCallback6 cb)
+{
+  m_downTarget6 = cb;
+}
+
+IpL4Protocol::DownTargetCallback
+WormL4Protocol::GetDownTarget (void) const
+{
+  return m_downTarget;
+}
+
+IpL4Protocol::DownTargetCallback6
+WormL4Protocol::GetDownTarget6 (void) const
+{
+  return m_downTarget6;
+}
+
+} // namespace ns3
@@ -0,0 +1,70 @@
+#ifndef WORM_L4_PROTOCOL_H
+#define WORM_L4_PROTOCOL_H
+
+#include "ns3/ip-l4-protocol.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/callback.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Node;
+class Packet;
+
+/**
+ * Bare IPv4 transport for WormApplication: worm packets go straight to
+ * Ipv4L3Protocol with their own protocol number and come back through
+ * Receive (), without sockets, endpoint demultiplexing, ports or a
+ * transport header.  All the worm needs is "a packet from X reached this
+ * node", so one receive callback per node is enough.
+ *
+ * Aggregating it to a node that already has an Ipv4 stack inserts it into
+ * Ipv4L3Protocol.
+ */
+class WormL4Protocol : public IpL4Protocol
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /// From the RFC 3692 experimentation range.
+  static const uint8_t PROT_NUMBER;
+
+  WormL4Protocol ();
+  virtual ~WormL4Protocol ();
+
+  /**
+   * Set the callback invoked with every worm packet this node receives,
+   * and the address it came from.  A null callback drops them.
+   */
+  void SetReceiveCallback (Callback<void, Ptr<Packet>, Ipv4Address> callback);
+
+  /**
+   * Hand a packet to IPv4, which routes it like any other.
+   */
+  void Send (Ptr<Packet> packet, Ipv4Address source, Ipv4Address destination);
+
+  // inherited from IpL4Protocol
+  virtual int GetProtocolNumber (void) const;
+  virtual enum IpL4Protocol::RxStatus Receive (Ptr<Packet> p, Ipv4Header const &header,
+                                               Ptr<Ipv4Interface> incomingInterface);
+  virtual enum IpL4Protocol::RxStatus Receive (Ptr<Packet> p, Ipv6Header const &header,
+                                               Ptr<Ipv6Interface> incomingInterface);
+  virtual void SetDownTarget (IpL4Protocol::DownTargetCallback cb);
+  virtual void SetDownTarget6 (IpL4Protocol::DownTargetCallback6 cb);
+  virtual IpL4Protocol::DownTargetCallback GetDownTarget (void) const;
+  virtual IpL4Protocol::DownTargetCallback6 GetDownTarget6 (void) const;
+
+protected:
+  virtual void DoDispose (void);
+  virtual void NotifyNewAggregate (void);
+
+private:
+  Ptr<Node> m_node;
+  Callback<void, Ptr<Packet>, Ipv4Address> m_rxCallback;
+  IpL4Protocol::DownTargetCallback m_downTarget;
+  IpL4Protocol::DownTargetCallback6 m_downTarget6;
+};
+
+} // namespace ns3
+
+#endif /* WORM_L4_PROTOCOL_H */
@@ -0,0 +1,283 @@
+#include "worm-scan-strategy.h"
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WormScanStrategy");
+
+NS_OBJECT_ENSURE_REGISTERED (WormScanStrategy);
+NS_OBJECT_ENSURE_REGISTERED (UniformScanStrategy);
+NS_OBJECT_ENSURE_REGISTERED (PermutationScanStrategy);
+NS_OBJECT_ENSURE_REGISTERED (HitListScanStrategy);
+NS_OBJECT_ENSURE_REGISTERED (LocalPreferenceScanStrategy);
+NS_OBJECT_ENSURE_REGISTERED (SequentialScanStrategy);
+
+TypeId
+WormScanStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WormScanStrategy")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+WormScanStrategy::WormScanStrategy ()
+  : m_range (1),
+    m_self (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WormScanStrategy::~WormScanStrategy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WormScanStrategy::Setup (uint32_t range, uint32_t self, Ptr<UniformRandomVariable> rng)
+{
+  NS_LOG_FUNCTION (this << range << self);
+  NS_ASSERT (range > 0);
+  m_range = range;
+  m_self = self;
+  m_rng = rng;
+  DoSetup ();
+}
+
+void
+WormScanStrategy::DoSetup (void)
+{
+}
+
+void
+WormScanStrategy::DoDispose (void)
+{
+  m_rng = 0;
+  Object::DoDispose ();
+}
+
+TypeId
+UniformScanStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UniformScanStrategy")
+    .SetParent<WormScanStrategy> ()
+    .AddConstructor<UniformScanStrategy> ()
+  ;
+  return tid;
+}
+
+uint32_t
+UniformScanStrategy::Next (void)
+{
+  return m_rng->GetInteger (0, m_range - 1);
+}
+
+namespace {
+
+// murmur3's finaliser, the Feistel round function
+uint32_t
+Mix (uint32_t x)
+{
+  x ^= x >> 16;
+  x *= 0x85ebca6b;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35;
+  x ^= x >> 16;
+  return x;
+}
+
+} // anonymous namespace
+
+TypeId
+PermutationScanStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PermutationScanStrategy")
+    .SetParent<WormScanStrategy> ()
+    .AddConstructor<PermutationScanStrategy> ()
+    .AddAttribute ("Key", "Permutation key shared by every worm, 0 for a random key per worm",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PermutationScanStrategy::m_key),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+PermutationScanStrategy::PermutationScanStrategy ()
+  : m_halfBits (1),
+    m_counter (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PermutationScanStrategy::DoSetup (void)
+{
+  uint32_t bits = 2;
+  while (bits < 32 && (uint64_t (1) << bits) < m_range)
+    {
+      bits += 2;
+    }
+  m_halfBits = bits / 2;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_roundKeys[i] = m_key == 0 ? m_rng->GetInteger (0, 0x7fffffff) * 2 + 1 : Mix (m_key + i);
+    }
+  m_counter = m_rng->GetInteger (0, m_range - 1);
+}
+
+uint32_t
+PermutationScanStrategy::Encrypt (uint32_t x) const
+{
+  uint32_t mask = (uint32_t (1) << m_halfBits) - 1;
+  uint32_t left = x >> m_halfBits;
+  uint32_t right = x & mask;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      uint32_t next = left ^ (Mix (right ^ m_roundKeys[i]) & mask);
+      left = right;
+      right = next;
+    }
+  return (left << m_halfBits) | right;
+}
+
+uint32_t
+PermutationScanStrategy::Next (void)
+{
+  // cycle walking keeps the cipher a permutation of [0, range)
+  uint32_t target = Encrypt (m_counter);
+  while (target >= m_range)
+    {
+      target = Encrypt (target);
+    }
+  m_counter = m_counter + 1 == m_range ? 0 : m_counter + 1;
+  return target;
+}
+
+TypeId
+HitListScanStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HitListScanStrategy")
+    .SetParent<WormScanStrategy> ()
+    .AddConstructor<HitListScanStrategy> ()
+    .AddAttribute ("Offset", "Index of the first target on the hit list",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HitListScanStrategy::m_offset),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Size", "Number of targets on the hit list",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HitListScanStrategy::m_size),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+HitListScanStrategy::HitListScanStrategy ()
+  : m_start (0),
+    m_done (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+HitListScanStrategy::DoSetup (void)
+{
+  m_offset = std::min (m_offset, m_range);
+  m_size = std::min (m_size, m_range - m_offset);
+  m_start = m_size > 0 ? m_rng->GetInteger (0, m_size - 1) : 0;
+  m_done = 0;
+}
+
+uint32_t
+HitListScanStrategy::Next (void)
+{
+  if (m_done < m_size)
+    {
+      return m_offset + (m_start + m_done++) % m_size;
+    }
+  return m_rng->GetInteger (0, m_range - 1);
+}
+
+TypeId
+LocalPreferenceScanStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LocalPreferenceScanStrategy")
+    .SetParent<WormScanStrategy> ()
+    .AddConstructor<LocalPreferenceScanStrategy> ()
+    .AddAttribute ("LocalProbability", "Probability of scanning the worm's own block",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&LocalPreferenceScanStrategy::m_localProbability),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("BlockSize", "Number of targets in a block",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&LocalPreferenceScanStrategy::m_blockSize),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+LocalPreferenceScanStrategy::LocalPreferenceScanStrategy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LocalPreferenceScanStrategy::Next (void)
+{
+  if (m_self < m_range && m_rng->GetValue () < m_localProbability)
+    {
+      uint32_t block = m_self / m_blockSize * m_blockSize;
+      uint32_t size = std::min (m_blockSize, m_range - block);
+      return block + m_rng->GetInteger (0, size - 1);
+    }
+  return m_rng->GetInteger (0, m_range - 1);
+}
+
+TypeId
+SequentialScanStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SequentialScanStrategy")
+    .SetParent<WormScanStrategy> ()
+    .AddConstructor<SequentialScanStrategy> ()
+    .AddAttribute ("RandomStart", "Start at a random index instead of the one after the worm's own",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&SequentialScanStrategy::m_randomStart),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+SequentialScanStrategy::SequentialScanStrategy ()
+  : m_next (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+SequentialScanStrategy::DoSetup (void)
+{
+  if (m_randomStart)
+    {
+      m_next = m_rng->GetInteger (0, m_range - 1);
+    }
+  else
+    {
+      m_next = m_self + 1 < m_range ? m_self + 1 : 0;
+    }
+}
+
+uint32_t
+SequentialScanStrategy::Next (void)
+{
+  uint32_t target = m_next;
+  m_next = m_next + 1 == m_range ? 0 : m_next + 1;
+  return target;
+}
+
+} // namespace ns3
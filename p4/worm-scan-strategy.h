@@ -0,0 +1,171 @@
+#ifndef WORM_SCAN_STRATEGY_H
+#define WORM_SCAN_STRATEGY_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * Picks the targets a WormApplication scans.
+ *
+ * The target space is the ScanRange indices of the worm, index k standing
+ * for ScanNetwork's /16 + k * ScanStride + ScanHost.  A strategy only hands
+ * out indices; the worm turns them into addresses and skips its own.
+ * Every strategy keeps O(1) state and costs O(1) (expected) per draw, and
+ * takes all its randomness from the worm's scan stream, so AssignStreams ()
+ * fixes it as well.
+ *
+ * The worm creates its strategy from the ScanStrategy attribute when it
+ * starts scanning; the strategies' own parameters are attributes that
+ * scenarios set with Config::SetDefault.
+ */
+class WormScanStrategy : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  WormScanStrategy ();
+  virtual ~WormScanStrategy ();
+
+  /**
+   * Prepare for scanning; called once, before the first Next ().
+   *
+   * \param range number of targets, indexed 0 to range - 1
+   * \param self index of the scanning host, or range if it is no target
+   * \param rng scan stream of the worm
+   */
+  void Setup (uint32_t range, uint32_t self, Ptr<UniformRandomVariable> rng);
+
+  /**
+   * \return the index of the next target
+   */
+  virtual uint32_t Next (void) = 0;
+
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * Called at the end of Setup (), once the members below are set.
+   */
+  virtual void DoSetup (void);
+
+  uint32_t m_range;
+  uint32_t m_self;
+  Ptr<UniformRandomVariable> m_rng;
+};
+
+/**
+ * Independent uniform draws with replacement: the original worm, which
+ * may probe the same target many times.
+ */
+class UniformScanStrategy : public WormScanStrategy
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual uint32_t Next (void);
+};
+
+/**
+ * Full-cycle permutation scanning: every target once per ScanRange draws.
+ *
+ * The permutation is a 4-round Feistel cipher over the smallest even
+ * number of bits that covers the range, walked until it lands inside it
+ * (fewer than 4 rounds trips on average), applied to a counter that starts
+ * at a random index.  With Key 0 each worm draws its own key; a fixed Key
+ * gives every worm the same permutation from a different starting point,
+ * as in Staniford's permutation scanning.
+ */
+class PermutationScanStrategy : public WormScanStrategy
+{
+public:
+  static TypeId GetTypeId (void);
+
+  PermutationScanStrategy ();
+
+  virtual uint32_t Next (void);
+
+protected:
+  virtual void DoSetup (void);
+
+private:
+  uint32_t Encrypt (uint32_t x) const;
+
+  uint32_t m_key;
+  uint32_t m_roundKeys[4];
+  uint32_t m_halfBits;
+  uint32_t m_counter;  //!< next counter value, in [0, range)
+};
+
+/**
+ * Hit-list scanning: the Size targets from index Offset on, typically the
+ * populated block of the address plan, are walked once in order from a
+ * random entry, then scanning falls back to uniform draws.
+ */
+class HitListScanStrategy : public WormScanStrategy
+{
+public:
+  static TypeId GetTypeId (void);
+
+  HitListScanStrategy ();
+
+  virtual uint32_t Next (void);
+
+protected:
+  virtual void DoSetup (void);
+
+private:
+  uint32_t m_offset;
+  uint32_t m_size;
+  uint32_t m_start;
+  uint32_t m_done;
+};
+
+/**
+ * Local-subnet preferential scanning, after Code Red II: with probability
+ * LocalProbability the target is drawn from the BlockSize indices around
+ * the worm's own, otherwise from the whole range.  Worms outside the range
+ * always scan uniformly.
+ */
+class LocalPreferenceScanStrategy : public WormScanStrategy
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LocalPreferenceScanStrategy ();
+
+  virtual uint32_t Next (void);
+
+private:
+  double m_localProbability;
+  uint32_t m_blockSize;
+};
+
+/**
+ * Sequential scanning, after Blaster: consecutive indices, wrapping at the
+ * end of the range, from a random index or from the one after the worm's
+ * own.
+ */
+class SequentialScanStrategy : public WormScanStrategy
+{
+public:
+  static TypeId GetTypeId (void);
+
+  SequentialScanStrategy ();
+
+  virtual uint32_t Next (void);
+
+protected:
+  virtual void DoSetup (void);
+
+private:
+  bool m_randomStart;
+  uint32_t m_next;
+};
+
+} // namespace ns3
+
+#endif /* WORM_SCAN_STRATEGY_H */
@@ -0,0 +1,199 @@
+// Convert a binary worm trace (see worm-trace.h) to NetAnim XML.
+//
+// Usage: worm-trace-to-netanim <trace.bin> <anim.xml>
+//
+// Nodes and links become the NetAnim topology, every infection turns the
+// node blue at its infection time and every link count record becomes a
+// link description update carrying the number of packets sent so far.
+// Standalone: it does not link against ns-3.
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+
+namespace {
+
+enum RecordType
+{
+  NODE = 1,
+  LINK = 2,
+  INFECTION = 3,
+  LINK_COUNT = 4
+};
+
+struct Node
+{
+  uint32_t id;
+  double x;
+  double y;
+};
+
+struct Link
+{
+  uint32_t a;
+  uint32_t b;
+};
+
+template <typename T>
+bool
+Read (FILE *in, T &value)
+{
+  return std::fread (&value, sizeof (T), 1, in) == 1;
+}
+
+void
+WriteTopology (std::ostream &out, const std::vector<Node> &nodes, const std::vector<Link> &links)
+{
+  double minX = 0, minY = 0, maxX = 0, maxY = 0;
+  for (size_t i = 0; i < nodes.size (); i++)
+    {
+      if (i == 0 || nodes[i].x < minX) minX = nodes[i].x;
+      if (i == 0 || nodes[i].y < minY) minY = nodes[i].y;
+      if (i == 0 || nodes[i].x > maxX) maxX = nodes[i].x;
+      if (i == 0 || nodes[i].y > maxY) maxY = nodes[i].y;
+    }
+  out << "<topology minX=\"" << minX << "\" minY=\"" << minY
+      << "\" maxX=\"" << maxX << "\" maxY=\"" << maxY << "\">\n";
+  for (size_t i = 0; i < nodes.size (); i++)
+    {
+      out << "<node id=\"" << nodes[i].id << "\" sysId=\"0\" locX=\"" << nodes[i].x
+          << "\" locY=\"" << nodes[i].y << "\" />\n";
+    }
+  for (size_t i = 0; i < links.size (); i++)
+    {
+      out << "<link fromId=\"" << links[i].a << "\" toId=\"" << links[i].b
+          << "\" fd=\"\" td=\"\" ld=\"\" />\n";
+    }
+  out << "</topology>\n";
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      std::cerr << "usage: " << argv[0] << " <trace.bin> <anim.xml>" << std::endl;
+      return 1;
+    }
+
+  FILE *in = std::fopen (argv[1], "rb");
+  if (in == 0)
+    {
+      std::cerr << "cannot open " << argv[1] << std::endl;
+      return 1;
+    }
+
+  char magic[4];
+  uint32_t version;
+  if (std::fread (magic, 1, 4, in) != 4 || std::memcmp (magic, "WRMT", 4) != 0
+      || !Read (in, version) || version != 1)
+    {
+      std::cerr << argv[1] << " is not a version 1 worm trace" << std::endl;
+      std::fclose (in);
+      return 1;
+    }
+
+  std::ofstream out (argv[2]);
+  if (!out)
+    {
+      std::cerr << "cannot open " << argv[2] << std::endl;
+      std::fclose (in);
+      return 1;
+    }
+
+  std::vector<Node> nodes;
+  std::vector<Link> links;
+  bool topologyDone = false;
+  uint64_t infections = 0;
+
+  out << "<anim ver=\"netanim-3.105\" filetype=\"animation\" >\n";
+
+  uint8_t type;
+  while (Read (in, type))
+    {
+      if (type == NODE)
+        {
+          Node n;
+          if (!Read (in, n.id) || !Read (in, n.x) || !Read (in, n.y))
+            {
+              break;
+            }
+          nodes.push_back (n);
+          continue;
+        }
+      if (type == LINK)
+        {
+          uint32_t linkId;
+          Link l;
+          if (!Read (in, linkId) || !Read (in, l.a) || !Read (in, l.b))
+            {
+              break;
+            }
+          if (linkId >= links.size ())
+            {
+              links.resize (linkId + 1);
+            }
+          links[linkId] = l;
+          continue;
+        }
+
+      // the topology block precedes every timed record
+      if (!topologyDone)
+        {
+          WriteTopology (out, nodes, links);
+          topologyDone = true;
+        }
+
+      int64_t time;
+      if (!Read (in, time))
+        {
+          break;
+        }
+      double seconds = time / 1e9;
+
+      if (type == INFECTION)
+        {
+          uint32_t nodeId, infector;
+          if (!Read (in, nodeId) || !Read (in, infector))
+            {
+              break;
+            }
+          out << "<nu p=\"c\" t=\"" << seconds << "\" id=\"" << nodeId
+              << "\" r=\"0\" g=\"0\" b=\"250\" />\n";
+          infections++;
+        }
+      else if (type == LINK_COUNT)
+        {
+          uint32_t linkId;
+          uint64_t packets;
+          if (!Read (in, linkId) || !Read (in, packets) || linkId >= links.size ())
+            {
+              break;
+            }
+          out << "<linkupdate t=\"" << seconds << "\" fromId=\"" << links[linkId].a
+              << "\" toId=\"" << links[linkId].b << "\" ld=\"" << packets << " pkts\" />\n";
+        }
+      else
+        {
+          std::cerr << "unknown record type " << int (type) << ", stopping" << std::endl;
+          break;
+        }
+    }
+
+  if (!topologyDone)
+    {
+      WriteTopology (out, nodes, links);
+    }
+  out << "</anim>\n";
+  std::fclose (in);
+
+  std::cout << nodes.size () << " nodes, " << links.size () << " links, "
+            << infections << " infections written to " << argv[2] << std::endl;
+  return 0;
+}
@@ -0,0 +1,230 @@
+#include "worm-trace.h"
+#include "worm.h"
+
+#include <cstring>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/channel-list.h"
+#include "ns3/mobility-model.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-net-device.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WormTraceWriter");
+
+NS_OBJECT_ENSURE_REGISTERED (WormTraceWriter);
+
+const uint32_t WormTraceWriter::VERSION;
+
+TypeId
+WormTraceWriter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WormTraceWriter")
+    .SetParent<Object> ()
+    .AddConstructor<WormTraceWriter> ()
+    .AddAttribute ("BufferSize", "Bytes of records kept in memory before they are written out",
+                   UintegerValue (1 << 16),
+                   MakeUintegerAccessor (&WormTraceWriter::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> (64))
+    .AddAttribute ("CountInterval", "Period of the link packet count records, zero for totals only",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WormTraceWriter::m_countInterval),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+WormTraceWriter::WormTraceWriter ()
+  : m_file (0),
+    m_used (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WormTraceWriter::~WormTraceWriter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WormTraceWriter::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file != 0)
+    {
+      Flush ();
+      std::fclose (m_file);
+      m_file = 0;
+    }
+  Object::DoDispose ();
+}
+
+void
+WormTraceWriter::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  NS_ASSERT (m_file == 0);
+  m_file = std::fopen (filename.c_str (), "wb");
+  NS_ABORT_MSG_IF (m_file == 0, "Cannot open worm trace file " << filename);
+  m_buffer.resize (m_bufferSize);
+  m_used = 0;
+
+  uint32_t version = VERSION;
+  Put ("WRMT", 4);
+  Put (&version, sizeof (version));
+}
+
+void
+WormTraceWriter::Track (Ptr<WormApplication> app)
+{
+  NS_LOG_FUNCTION (this << app);
+  app->TraceConnectWithoutContext ("Infection", MakeCallback (&WormTraceWriter::NotifyInfection, this));
+}
+
+void
+WormTraceWriter::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint8_t type;
+
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+      uint32_t nodeId = node->GetId ();
+      double x = 0;
+      double y = 0;
+      if (mobility != 0)
+        {
+          x = mobility->GetPosition ().x;
+          y = mobility->GetPosition ().y;
+        }
+      type = NODE;
+      Put (&type, sizeof (type));
+      Put (&nodeId, sizeof (nodeId));
+      Put (&x, sizeof (x));
+      Put (&y, sizeof (y));
+    }
+
+  std::vector<Ptr<PointToPointChannel> > links;
+  for (uint32_t i = 0; i < ChannelList::GetNChannels (); i++)
+    {
+      Ptr<PointToPointChannel> channel = DynamicCast<PointToPointChannel> (ChannelList::GetChannel (i));
+      if (channel != 0 && channel->GetNDevices () == 2)
+        {
+          links.push_back (channel);
+        }
+    }
+
+  // sized once, so the counter pointers bound below stay valid
+  m_linkTx.assign (links.size (), 0);
+  for (uint32_t linkId = 0; linkId < links.size (); linkId++)
+    {
+      uint32_t nodeA = links[linkId]->GetDevice (0)->GetNode ()->GetId ();
+      uint32_t nodeB = links[linkId]->GetDevice (1)->GetNode ()->GetId ();
+      type = LINK;
+      Put (&type, sizeof (type));
+      Put (&linkId, sizeof (linkId));
+      Put (&nodeA, sizeof (nodeA));
+      Put (&nodeB, sizeof (nodeB));
+
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          links[linkId]->GetPointToPointDevice (j)->TraceConnectWithoutContext (
+            "PhyTxEnd", MakeBoundCallback (&WormTraceWriter::CountTx, &m_linkTx[linkId]));
+        }
+    }
+
+  if (!m_countInterval.IsZero ())
+    {
+      Simulator::Schedule (m_countInterval, &WormTraceWriter::WriteLinkCounts, this);
+    }
+}
+
+void
+WormTraceWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file == 0)
+    {
+      return;
+    }
+  m_countInterval = Seconds (0);
+  WriteLinkCounts ();
+  Flush ();
+  std::fclose (m_file);
+  m_file = 0;
+}
+
+void
+WormTraceWriter::NotifyInfection (uint32_t nodeId, Ipv4Address infector)
+{
+  uint8_t type = INFECTION;
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  uint32_t from = infector.Get ();
+  Put (&type, sizeof (type));
+  Put (&now, sizeof (now));
+  Put (&nodeId, sizeof (nodeId));
+  Put (&from, sizeof (from));
+}
+
+void
+WormTraceWriter::WriteLinkCounts (void)
+{
+  if (m_file == 0)
+    {
+      return;
+    }
+  uint8_t type = LINK_COUNT;
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  for (uint32_t linkId = 0; linkId < m_linkTx.size (); linkId++)
+    {
+      Put (&type, sizeof (type));
+      Put (&now, sizeof (now));
+      Put (&linkId, sizeof (linkId));
+      Put (&m_linkTx[linkId], sizeof (uint64_t));
+    }
+  if (!m_countInterval.IsZero ())
+    {
+      Simulator::Schedule (m_countInterval, &WormTraceWriter::WriteLinkCounts, this);
+    }
+}
+
+void
+WormTraceWriter::Put (const void *data, uint32_t size)
+{
+  if (m_file == 0)
+    {
+      return;
+    }
+  if (m_used + size > m_buffer.size ())
+    {
+      Flush ();
+    }
+  std::memcpy (&m_buffer[m_used], data, size);
+  m_used += size;
+}
+
+void
+WormTraceWriter::Flush (void)
+{
+  if (m_used > 0)
+    {
+      std::fwrite (&m_buffer[0], 1, m_used, m_file);
+      m_used = 0;
+    }
+}
+
+void
+WormTraceWriter::CountTx (uint64_t *counter, Ptr<const Packet> packet)
+{
+  (*counter)++;
+}
+
+} // namespace ns3
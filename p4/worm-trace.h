@@ -0,0 +1,94 @@
+#ifndef WORM_TRACE_H
+#define WORM_TRACE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Packet;
+class WormApplication;
+
+/**
+ * Compact, append-only binary trace of a worm run.
+ *
+ * The file starts with the 4 byte magic "WRMT" and a uint32 version,
+ * followed by records made of a one byte type and a fixed size body, all
+ * in host byte order:
+ *
+ *  - NODE        uint32 nodeId, double x, double y
+ *  - LINK        uint32 linkId, uint32 nodeA, uint32 nodeB
+ *  - INFECTION   int64 time (ns), uint32 nodeId, uint32 infector IPv4 address
+ *  - LINK_COUNT  int64 time (ns), uint32 linkId, uint64 packets sent so far
+ *
+ * Nodes and point-to-point links are written once by Start (), link
+ * counts every CountInterval (if non zero) and once more by Close ().
+ * Records go through an in-memory buffer that is only written out when
+ * full, so a run costs a handful of write calls.  worm-trace-to-netanim
+ * turns the file into NetAnim XML when the run is to be watched.
+ */
+class WormTraceWriter : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  enum RecordType
+  {
+    NODE = 1,
+    LINK = 2,
+    INFECTION = 3,
+    LINK_COUNT = 4
+  };
+
+  static const uint32_t VERSION = 1;
+
+  WormTraceWriter ();
+  virtual ~WormTraceWriter ();
+
+  void Open (std::string filename);
+
+  /**
+   * Record the infections of this application.
+   */
+  void Track (Ptr<WormApplication> app);
+
+  /**
+   * Write every node position and point-to-point link and start counting
+   * packets.  Call once the topology is complete, before Simulator::Run.
+   */
+  void Start (void);
+
+  /**
+   * Write the final link counts and flush the file.  Call after
+   * Simulator::Run and before Simulator::Destroy.
+   */
+  void Close (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void NotifyInfection (uint32_t nodeId, Ipv4Address infector);
+  void WriteLinkCounts (void);
+  void Put (const void *data, uint32_t size);
+  void Flush (void);
+
+  static void CountTx (uint64_t *counter, Ptr<const Packet> packet);
+
+  FILE *m_file;
+  std::vector<char> m_buffer;
+  uint32_t m_used;
+  uint32_t m_bufferSize;
+  Time m_countInterval;
+  std::vector<uint64_t> m_linkTx;
+};
+
+} // namespace ns3
+
+#endif /* WORM_TRACE_H */
@@ -0,0 +1,597 @@
+#include "worm.h"
+#include "worm-scan-strategy.h"
+#include "worm-l4-protocol.h"
+#include "../common/address-plan.h"
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/names.h"
+#include "ns3/socket.h"
+#include "ns3/socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/enum.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/netanim-module.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WormApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (WormApplication);
+
+WormHelper::WormHelper (std::string protocol, Address address)
+{
+  m_factory.SetTypeId ("ns3::WormApplication");
+  m_factory.Set ("Protocol", StringValue (protocol));
+  m_factory.Set ("Local", AddressValue (address));
+}
+
+void
+WormHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+WormHelper::Install (Ptr<Node> node) const
+{
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+WormHelper::Install (std::string nodeName) const
+{
+  Ptr<Node> node = Names::Find<Node> (nodeName);
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+WormHelper::Install (NodeContainer c) const
+{
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      apps.Add (InstallPriv (*i));
+    }
+
+  return apps;
+}
+
+int64_t
+WormHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  Ptr<Node> node;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      node = (*i);
+      for (uint32_t j = 0; j < node->GetNApplications (); j++)
+        {
+          Ptr<WormApplication> worm = DynamicCast<WormApplication> (node->GetApplication (j));
+          if (worm)
+            {
+              currentStream += worm->AssignStreams (currentStream);
+            }
+        }
+    }
+  return (currentStream - stream);
+}
+
+Ptr<Application>
+WormHelper::InstallPriv (Ptr<Node> node) const
+{
+  Ptr<Application> app = m_factory.Create<Application> ();
+  node->AddApplication (app);
+
+  return app;
+}
+
+TypeId
+WormApplication::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::WormApplication")
+	.SetParent<Application> ()
+	.AddConstructor<WormApplication> ()
+	.AddAttribute ("SendSize", "The amount of data to send each time.",
+					UintegerValue (32),
+					MakeUintegerAccessor (&WormApplication::m_sendSize),
+					MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("DataRate", "The data rate in on state.",
+					DataRateValue (DataRate ("500kb/s")),
+					MakeDataRateAccessor (&WormApplication::m_dataRate),
+					MakeDataRateChecker ())
+	.AddAttribute ("Local",
+					"The Address on which to Bind the rx socket.",
+					AddressValue (),
+					MakeAddressAccessor (&WormApplication::m_local),
+					MakeAddressChecker ())
+	.AddAttribute ("Protocol", "The type of protocol to use: a socket factory, or ns3::WormL4Protocol for bare IPv4.",
+					TypeIdValue (UdpSocketFactory::GetTypeId ()),
+					MakeTypeIdAccessor (&WormApplication::m_tid),
+					MakeTypeIdChecker ())
+	.AddAttribute ("Port", "Port on which we listen for incoming packets.",
+					UintegerValue(1000),
+					MakeUintegerAccessor (&WormApplication::m_port),
+					MakeUintegerChecker<uint16_t> ())
+	.AddAttribute ("ConnectCount", "Number of scans an infected worm runs at once, each from its own sender socket",
+					UintegerValue(1),
+					MakeUintegerAccessor (&WormApplication::m_cCount),
+					MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("Infected", "State of infection.",
+					BooleanValue(false),
+					MakeBooleanAccessor (&WormApplication::m_infected),
+					MakeBooleanChecker())
+	.AddAttribute ("NodeID", "ID of node.",
+					UintegerValue(1),
+					MakeUintegerAccessor (&WormApplication::m_nodeID),
+					MakeUintegerChecker<uint32_t> ())
+	.AddAttribute ("Interval", "Interval in seconds for peers choosing",
+					DoubleValue(1),
+					MakeDoubleAccessor(&WormApplication::m_interval),
+					MakeDoubleChecker<double> ())
+	.AddAttribute ("Payload", "Size of payload to send per interval in packets",
+					UintegerValue(10),
+					MakeUintegerAccessor (&WormApplication::m_payload),
+					MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("InfectThreshold", "Packets received before the node is infected",
+					UintegerValue(4),
+					MakeUintegerAccessor (&WormApplication::m_infectThreshold),
+					MakeUintegerChecker<uint32_t> ())
+	.AddAttribute ("ScanNetwork", "Scan targets start at the /16 of this address",
+					Ipv4AddressValue ("10.2.0.0"),
+					MakeIpv4AddressAccessor (&WormApplication::m_scanNetwork),
+					MakeIpv4AddressChecker ())
+	.AddAttribute ("ScanHost", "Offset of every scanned address within its subnet",
+					UintegerValue(2),
+					MakeUintegerAccessor (&WormApplication::m_scanHost),
+					MakeUintegerChecker<uint8_t> ())
+	.AddAttribute ("ScanRange", "Number of consecutive subnets from the /16 of ScanNetwork that are scanned",
+					UintegerValue(256),
+					MakeUintegerAccessor (&WormApplication::m_scanRange),
+					MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("ScanStride", "Size in addresses of each scanned subnet",
+					UintegerValue(256),
+					MakeUintegerAccessor (&WormApplication::m_scanStride),
+					MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("ScanStrategy", "TypeId of the WormScanStrategy that picks the scanned subnets",
+					TypeIdValue (UniformScanStrategy::GetTypeId ()),
+					MakeTypeIdAccessor (&WormApplication::m_scanStrategyTid),
+					MakeTypeIdChecker ())
+	.AddAttribute ("PrintInfections", "Print a line to stdout when this node is infected",
+					BooleanValue(true),
+					MakeBooleanAccessor (&WormApplication::m_printInfections),
+					MakeBooleanChecker())
+	.AddAttribute ("BurstSend", "Queue packets of a scan train ahead of time while the outgoing link is busy; needs ConnectCount 1",
+					BooleanValue(false),
+					MakeBooleanAccessor (&WormApplication::m_burstSend),
+					MakeBooleanChecker())
+	.AddAttribute ("SharedPayload", "Send copies of one template packet instead of building every packet",
+					BooleanValue(false),
+					MakeBooleanAccessor (&WormApplication::m_sharedPayload),
+					MakeBooleanChecker())
+	.AddAttribute ("ElideMisses", "Count UDP and bare IPv4 scans to addresses missing from the target index instead of sending them",
+					BooleanValue(false),
+					MakeBooleanAccessor (&WormApplication::m_elideMisses),
+					MakeBooleanChecker())
+	.AddTraceSource ("InfectEvent", "The application is infected",
+                     MakeTraceSourceAccessor (&WormApplication::m_infectTrace))
+	.AddTraceSource ("Infection", "The node is infected; carries its node id and the infector address",
+                     MakeTraceSourceAccessor (&WormApplication::m_infectionTrace))
+	.AddTraceSource ("ElidedScan", "A scan missed and was counted instead of sent; carries the target and the bytes the train would have sent",
+                     MakeTraceSourceAccessor (&WormApplication::m_elidedScanTrace))
+
+	;
+  return tid;
+}
+
+WormApplication::WormApplication ()
+  : m_socket (0),
+	m_infected (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_packsRec = 0;
+  m_aP = NULL;
+  m_targetIndex = NULL;
+  m_elidedScans = 0;
+  m_elidedBytes = 0;
+  m_scanRng = CreateObject<UniformRandomVariable> ();
+}
+
+WormApplication::~WormApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void WormApplication::DoDispose (void)
+{
+	NS_LOG_FUNCTION (this);
+	m_socket = 0;
+	m_scanSockets.clear ();
+	m_raw = 0;
+	m_scanRng = 0;
+	m_scanStrategy = 0;
+	m_txDevice = 0;
+	m_txQueue = 0;
+	// chain up
+	Application::DoDispose ();
+}
+
+bool WormApplication::isInfected()
+{
+	return m_infected;
+}
+
+void WormApplication::setAnimPoint(AnimationInterface *p) {
+	m_aP = p;
+}
+
+void WormApplication::SetTargetIndex (const AddressPlan *index)
+{
+	m_targetIndex = index;
+}
+
+uint64_t WormApplication::GetElidedScans (void) const
+{
+	return m_elidedScans;
+}
+
+uint64_t WormApplication::GetElidedBytes (void) const
+{
+	return m_elidedBytes;
+}
+
+int64_t WormApplication::AssignStreams (int64_t stream)
+{
+	NS_LOG_FUNCTION (this << stream);
+	m_scanRng->SetStream (stream);
+	return 1;
+}
+
+void WormApplication::StartApplication ()    // Called at time specified by Start
+{
+	NS_LOG_FUNCTION (this);
+	// the burst state describes the queue of one train only
+	NS_ABORT_MSG_IF (m_burstSend && m_cCount > 1, "BurstSend needs ConnectCount 1, not " << m_cCount);
+	if (m_tid == WormL4Protocol::GetTypeId ()) {
+		m_raw = GetNode ()->GetObject<WormL4Protocol> ();
+		if (m_raw == 0) {
+			m_raw = CreateObject<WormL4Protocol> ();
+			GetNode ()->AggregateObject (m_raw);
+		}
+		m_raw->SetReceiveCallback (MakeCallback (&WormApplication::Receive, this));
+	}
+	// Create the socket if not already
+	else if (!m_socket)
+	{
+		m_socket = Socket::CreateSocket (GetNode (), m_tid);
+		m_socket->Bind (m_local);
+		m_socket->Listen ();
+
+		if(m_tid == TcpSocketFactory::GetTypeId ()) {
+			m_socket->SetConnectCallback (
+				MakeCallback (&WormApplication::ConnectionSucceeded, this),
+				MakeCallback (&WormApplication::ConnectionFailed, this));
+			m_socket->SetCloseCallbacks (
+				MakeCallback (&WormApplication::ConnectionFailed, this),
+				MakeCallback (&WormApplication::ConnectionFailed, this));
+		}
+
+	}
+
+	if (m_socket) {
+		m_socket->SetRecvCallback (MakeCallback (&WormApplication::HandleReceive, this));
+	}
+	if(m_infected == true ) {
+		// seeds have no infector
+		m_infectionTrace (GetNode ()->GetId (), Ipv4Address::GetAny ());
+		WormApplication::StartScanning();
+	}
+}
+
+void WormApplication::StartScanning (void) {
+	NS_LOG_FUNCTION(this);
+	uint32_t scans = std::max<uint32_t> (m_cCount, 1);
+	m_scanTargets.resize (scans);
+	if (m_elideMisses && m_targetIndex != NULL) {
+		m_scanLinks.resize (scans, GetNode ()->GetNDevices ());
+		m_linkBusyUntil.resize (GetNode ()->GetNDevices ());
+	}
+	if (m_raw == 0) {
+		// the first scan sends from the receive socket, as a single scan always did
+		m_scanSockets.push_back (m_socket);
+		for(uint32_t i = 1; i < scans; i++) {
+			Ptr<Socket> socket = Socket::CreateSocket (GetNode (), m_tid);
+			socket->Bind ();
+
+			if(m_tid == TcpSocketFactory::GetTypeId ()) {
+				socket->SetConnectCallback (
+					MakeCallback (&WormApplication::ConnectionSucceeded, this),
+					MakeCallback (&WormApplication::ConnectionFailed, this));
+				socket->SetCloseCallbacks (
+					MakeCallback (&WormApplication::ConnectionFailed, this),
+					MakeCallback (&WormApplication::ConnectionFailed, this));
+			}
+			m_scanSockets.push_back (socket);
+		}
+	}
+	for(uint32_t i = 0; i < scans; i++) {
+		WormApplication::NewPeer(i);
+	}
+}
+
+uint32_t WormApplication::GetScan (Ptr<Socket> socket) const
+{
+	// ConnectCount is small, a linear search is fine
+	for (uint32_t i = 0; i < m_scanSockets.size (); i++) {
+		if (m_scanSockets[i] == socket) {
+			return i;
+		}
+	}
+	return m_scanSockets.size ();
+}
+
+void WormApplication::HandleReceive (Ptr<Socket> socket)
+{
+	NS_LOG_FUNCTION (this << socket);
+
+	Ptr<Packet> packet;
+	Address from;
+	while ((packet = socket->RecvFrom (from)))
+	{
+		if (InetSocketAddress::IsMatchingType (from))
+			{
+				NS_LOG_LOGIC ("At time " << Simulator::Now ().GetSeconds () << "s received " << packet->GetSize () << " bytes from " <<
+							InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
+							InetSocketAddress::ConvertFrom (from).GetPort ());
+				Receive (packet, InetSocketAddress::ConvertFrom (from).GetIpv4 ());
+			}
+
+		packet->RemoveAllPacketTags ();
+		packet->RemoveAllByteTags ();
+	}
+}
+
+void WormApplication::Receive (Ptr<Packet> packet, Ipv4Address from)
+{
+	if(m_packsRec++ >= m_infectThreshold && !m_infected) {
+		Ptr<Node> node = GetNode ();
+		m_infected = true;
+		m_infectTrace (packet);
+		m_infectionTrace (node->GetId (), from);
+		if (m_aP != NULL) {m_aP->UpdateNodeColor(node,0,0,250); }
+		if (m_printInfections) {
+			std::cout << "Node "<< m_nodeID << " infected at " <<
+						Simulator::Now().GetSeconds() << "s by " << from << std::endl;
+		}
+
+		WormApplication::StartScanning();
+	}
+}
+
+void WormApplication::StopApplication(void) {
+	NS_LOG_FUNCTION (this);
+	if (m_socket != 0)
+	{
+		m_socket->Close ();
+	}
+	for (uint32_t i = 1; i < m_scanSockets.size (); i++)
+	{
+		m_scanSockets[i]->Close ();
+	}
+	if (m_raw != 0)
+	{
+		m_raw->SetReceiveCallback (MakeNullCallback<void, Ptr<Packet>, Ipv4Address> ());
+	}
+}
+
+void WormApplication::ConnectionSucceeded(Ptr<Socket> socket) {
+	NS_LOG_FUNCTION (this);
+	NS_LOG_INFO ("Found a sink!");
+	uint32_t scan = GetScan (socket);
+	if (scan < m_scanSockets.size ()) {
+		WormApplication::udpDataSend(scan, m_payload);
+	}
+}
+
+void WormApplication::ConnectionFailed(Ptr<Socket> socket) {
+	NS_LOG_FUNCTION (this << socket);
+	// the receive socket of a clean worm runs no scan
+	uint32_t scan = GetScan (socket);
+	if (scan < m_scanSockets.size ()) {
+		WormApplication::NewPeer(scan);
+	}
+}
+
+void WormApplication::NewPeer(uint32_t scan) {
+	NS_LOG_FUNCTION (this << scan);
+	uint32_t randAdd32;
+	Ipv4Address newPeer;
+
+	if (m_scanStrategy == 0) {
+		ObjectFactory factory;
+		factory.SetTypeId (m_scanStrategyTid);
+		m_scanStrategy = factory.Create<WormScanStrategy> ();
+		// our own index, if we are in the scanned space at all
+		uint32_t offset = InetSocketAddress::ConvertFrom (m_local).GetIpv4 ().Get ()
+			- (m_scanNetwork.Get () & 0xffff0000) - m_scanHost;
+		uint32_t self = offset % m_scanStride == 0 && offset / m_scanStride < m_scanRange ? offset / m_scanStride : m_scanRange;
+		m_scanStrategy->Setup (m_scanRange, self, m_scanRng);
+	}
+
+	do {
+		randAdd32 = m_scanNetwork.Get () & 0xffff0000;
+		randAdd32 += m_scanStrategy->Next () * m_scanStride;
+		randAdd32 += m_scanHost;
+
+		newPeer.Set(randAdd32);
+	} while (InetSocketAddress (newPeer, m_port) == m_local);
+
+	NS_LOG_LOGIC ("Trying new peer! " << newPeer << " at " << Simulator::Now() << " from " << m_local);
+
+	if (m_elideMisses && m_targetIndex != NULL && m_tid != TcpSocketFactory::GetTypeId ()
+			&& m_targetIndex->LookupNode (newPeer) == AddressPlan::NO_NODE) {
+		// nobody would receive the train: count it, keep its access link
+		// busy for as long as the train would have, and move on when it
+		// would have ended
+		uint32_t bytes = m_payload * GetWireSize ();
+		m_elidedScans++;
+		m_elidedBytes += bytes;
+		m_elidedScanTrace (newPeer, bytes);
+		uint32_t link = GetAccessLink (newPeer);
+		if (link < m_linkBusyUntil.size ()) {
+			DataRateValue rate;
+			GetNode ()->GetDevice (link)->GetAttribute ("DataRate", rate);
+			Time start = std::max (m_linkBusyUntil[link], Simulator::Now ());
+			m_linkBusyUntil[link] = start + Seconds (bytes * 8.0 / rate.Get ().GetBitRate ());
+		}
+		Simulator::Schedule (Seconds (m_interval), &WormApplication::NewPeer, this, scan);
+		return;
+	}
+
+	m_scanTargets[scan] = newPeer;
+	if (scan < m_scanLinks.size ()) {
+		m_scanLinks[scan] = GetAccessLink (newPeer);
+	}
+	if (m_raw == 0) {
+		m_scanSockets[scan]->Connect (InetSocketAddress (newPeer, m_port));
+	}
+	if (m_burstSend) {
+		ResolveTxDevice (newPeer);
+	}
+
+	if(m_tid == TcpSocketFactory::GetTypeId ()) {
+		;
+	}
+	else {
+		WormApplication::udpDataSend(scan, m_payload);
+	}
+
+}
+
+void WormApplication::udpDataSend(uint32_t scan, uint32_t remaining) {
+	NS_LOG_FUNCTION(this << scan << remaining);
+
+	if (scan < m_scanLinks.size () && m_scanLinks[scan] < m_linkBusyUntil.size ()
+			&& remaining > 0 && m_linkBusyUntil[m_scanLinks[scan]] > Simulator::Now ()) {
+		// the link is still serializing elided trains
+		Simulator::Schedule (m_linkBusyUntil[m_scanLinks[scan]] - Simulator::Now (), &WormApplication::udpDataSend, this, scan, remaining);
+		return;
+	}
+
+	if( remaining > 0 ) {
+		Time onInterval = Seconds (m_interval/m_payload);
+		Time departure = Simulator::Now ();
+		do {
+			Ptr<Packet> packet = m_sharedPayload ? m_payloadTemplate.Get (m_sendSize) : Create<Packet> (m_sendSize);
+			if (m_raw != 0) {
+				m_raw->Send (packet, InetSocketAddress::ConvertFrom (m_local).GetIpv4 (), m_scanTargets[scan]);
+			}
+			else {
+				m_scanSockets[scan]->Send (packet);
+			}
+			remaining--;
+			departure += onInterval;
+		} while (m_burstSend && remaining > 0 && CanSendEarly (departure));
+		Simulator::Schedule (departure - Simulator::Now (), &WormApplication::udpDataSend, this, scan, remaining );
+	}
+	else {
+		WormApplication::NewPeer(scan);
+	}
+}
+
+void WormApplication::ResolveTxDevice (Ipv4Address peer)
+{
+	NS_LOG_FUNCTION (this << peer);
+	m_txDevice = 0;
+	m_txQueue = 0;
+
+	Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (GetRouteDevice (peer));
+	if (device == 0 || device->GetQueue ()->GetInstanceTypeId () != DropTailQueue::GetTypeId ()) {
+		// only the point-to-point DropTail path has a predictable drain time
+		return;
+	}
+	m_txDevice = device;
+	m_txQueue = device->GetQueue ();
+
+	EnumValue mode;
+	UintegerValue limit;
+	m_txQueue->GetAttribute ("Mode", mode);
+	m_txQueueBytes = (mode.Get () == DropTailQueue::QUEUE_MODE_BYTES);
+	m_txQueue->GetAttribute (m_txQueueBytes ? "MaxBytes" : "MaxPackets", limit);
+	m_txQueueLimit = limit.Get ();
+
+	DataRateValue rate;
+	m_txDevice->GetAttribute ("DataRate", rate);
+	m_txBitRate = rate.Get ().GetBitRate ();
+}
+
+Ptr<NetDevice> WormApplication::GetRouteDevice (Ipv4Address peer) const
+{
+	Ptr<Ipv4> ipv4 = GetNode ()->GetObject<Ipv4> ();
+	Ipv4Header header;
+	header.SetDestination (peer);
+	Socket::SocketErrno sockerr;
+	Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (0, header, 0, sockerr);
+	if (route == 0) {
+		return 0;
+	}
+	return route->GetOutputDevice ();
+}
+
+uint32_t WormApplication::GetAccessLink (Ipv4Address peer) const
+{
+	// without a route the train would have been dropped before any link,
+	// and only a point-to-point device has a known serialization rate
+	Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (GetRouteDevice (peer));
+	if (device == 0) {
+		return GetNode ()->GetNDevices ();
+	}
+	return device->GetIfIndex ();
+}
+
+uint32_t WormApplication::GetWireSize (void) const
+{
+	// UDP (not on the bare IPv4 transport), IPv4 and PPP headers are added
+	// before the packet is queued
+	return m_sendSize + (m_raw != 0 ? 0 : 8) + 20 + 2;
+}
+
+bool WormApplication::CanSendEarly (Time departure) const
+{
+	if (m_txDevice == 0) {
+		return false;
+	}
+
+	uint32_t wireSize = GetWireSize ();
+	if (m_txQueueBytes) {
+		if (m_txQueue->GetNBytes () + wireSize >= m_txQueueLimit) return false;
+	}
+	else {
+		if (m_txQueue->GetNPackets () >= m_txQueueLimit) return false;
+	}
+
+	// The queued bytes alone keep the link busy until at least this time;
+	// the packet in flight only extends it.
+	Time busyUntil = Simulator::Now () + Seconds (m_txQueue->GetNBytes () * 8.0 / m_txBitRate);
+	return departure < busyUntil;
+}
+
+} // namespace ns3
@@ -0,0 +1,226 @@
+#ifndef WORM_H
+#define WORM_H
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/application-container.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+
+#include <vector>
+
+#include "../common/payload-template.h"
+
+namespace ns3 {
+
+class AddressPlan;
+class AnimationInterface;
+class NetDevice;
+class Packet;
+class PointToPointNetDevice;
+class Queue;
+class Socket;
+class UniformRandomVariable;
+class WormL4Protocol;
+class WormScanStrategy;
+
+/**
+ * Self propagating UDP worm shared by every p4 topology.
+ *
+ * Every node runs one instance.  An infected instance repeatedly picks a
+ * target, the /16 of ScanNetwork plus k * ScanStride + ScanHost for a k in
+ * [0,ScanRange) chosen by the ScanStrategy (uniform by default, see
+ * worm-scan-strategy.h), and sends it a train of Payload packets spread
+ * over Interval seconds.  A
+ * clean instance becomes infected once it has received more than
+ * InfectThreshold worm packets, and then starts scanning itself.  The
+ * defaults scan host ScanHost of each /24 of the /16; a stride of 4 scans
+ * one host per /30 link of an AddressPlan, and a ScanRange that overflows
+ * the /16 reaches the rest of a large topology.
+ *
+ * With BurstSend enabled a single event hands every packet of the train
+ * whose nominal departure time falls while the outgoing point-to-point
+ * device is still busy straight to its DropTail queue.  When the worm is
+ * the only source on the access link such a packet would have been queued
+ * behind the same packets anyway, so the result is equivalent; other
+ * traffic on that queue can arrive between the nominal departures and
+ * would then be queued behind packets it used to overtake.  Packets that
+ * find the queue full are still sent one event each, so the saving is
+ * bounded by the queue depth, not by Payload.
+ * BurstSend tracks the device and queue of a single train, so it needs
+ * ConnectCount 1; StartApplication aborts when both are set.
+ *
+ * An infected instance runs ConnectCount scans at once, each with its own
+ * target and train.  The first scan sends from the receive socket; the
+ * others get their own ephemeral-port sockets, created when the instance
+ * starts scanning and reused for every target after, so clean instances
+ * hold no sender sockets.
+ *
+ * Protocol selects the transport: a socket factory, or WormL4Protocol,
+ * which hands the packets straight to IPv4 and delivers them back through
+ * a per-node callback, without sockets, ports or a UDP header.
+ *
+ * With SharedPayload enabled the packets of every train are copies of one
+ * template packet (see PayloadTemplate) instead of new packets.
+ *
+ * With ElideMisses enabled and a target index set, a UDP or bare IPv4 scan
+ * (any Protocol but TCP) whose target is not in the index is not sent: the
+ * miss and the bytes its train would have sent are counted, and the next
+ * scan starts one Interval later, as it would have after the train.  If the
+ * node routes the target out of a point-to-point device, the train's
+ * serialization time at that device's DataRate is added to a busy-until
+ * time kept per device, and this worm's next real packet out of the device
+ * waits until then.  The whole train is charged at once instead of spread
+ * over the Interval, and other applications on the node do not see the
+ * charge.  A target without a route charges nothing: the sender would have
+ * dropped the train.  Scans that hit are sent packet by packet as before.
+ */
+class WormApplication : public Application
+{
+public:
+	static TypeId GetTypeId (void);
+
+	WormApplication ();
+
+	virtual ~WormApplication ();
+
+	bool	isInfected();
+
+	void	setAnimPoint(AnimationInterface *p);
+
+	/**
+	 * Assign a fixed random variable stream number to the scan target
+	 * generator of this application.
+	 *
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this application
+	 */
+	int64_t	AssignStreams (int64_t stream);
+
+	/**
+	 * Set the index that ElideMisses resolves scan targets against.  It
+	 * must list the address of every host the scan can reach and outlive
+	 * the simulation.
+	 */
+	void	SetTargetIndex (const AddressPlan *index);
+
+	/**
+	 * \return the number of scans to unassigned addresses that were
+	 * counted instead of sent
+	 */
+	uint64_t	GetElidedScans (void) const;
+
+	/**
+	 * \return the bytes, UDP, IPv4 and PPP headers included, the elided
+	 * scans would have put on the access link
+	 */
+	uint64_t	GetElidedBytes (void) const;
+
+protected:
+	virtual void DoDispose (void);
+private:
+	// inherited from Application base class.
+	virtual void StartApplication (void);    // Called at time specified by Start
+	virtual void StopApplication (void);     // Called at time specified by Stop
+
+	Ptr<Socket>		m_socket;
+	Address			m_local;
+	Address			m_peer;
+	uint16_t		m_port;
+	uint32_t		m_sendSize;
+	uint32_t		m_cCount;
+	uint32_t		m_packsRec;
+	uint32_t		m_infectThreshold;
+	uint32_t		m_nodeID;
+	uint32_t		m_payload;
+	double			m_interval;
+	Ipv4Address		m_scanNetwork;
+	uint8_t			m_scanHost;
+	uint32_t		m_scanRange;
+	uint32_t		m_scanStride;
+	bool			m_printInfections;
+	bool			m_burstSend;
+	bool			m_elideMisses;
+	bool			m_sharedPayload;
+	PayloadTemplate	m_payloadTemplate;
+	const AddressPlan *m_targetIndex;
+	uint64_t		m_elidedScans;
+	uint64_t		m_elidedBytes;
+	DataRate		m_dataRate;
+	BooleanValue	m_infected;
+	TypeId			m_tid;
+	AnimationInterface *m_aP;
+	TypeId			m_scanStrategyTid;
+	Ptr<WormScanStrategy>	m_scanStrategy;	// created when the worm starts scanning
+	Ptr<WormL4Protocol>	m_raw;	// set when Protocol is WormL4Protocol
+	std::vector<Ptr<Socket> >	m_scanSockets;	// sender of each concurrent scan, socket transports only
+	std::vector<Ipv4Address>	m_scanTargets;	// target of each concurrent scan
+	std::vector<uint32_t>	m_scanLinks;	// device index of each concurrent scan, ElideMisses only
+	std::vector<Time>	m_linkBusyUntil;	// per device, end of the elided trains charged to it
+	Ptr<UniformRandomVariable>	m_scanRng;	// scan stream, drawn from by m_scanStrategy
+
+	// outgoing device of the one scan, only resolved in burst mode
+	Ptr<PointToPointNetDevice>	m_txDevice;
+	Ptr<Queue>		m_txQueue;
+	bool			m_txQueueBytes;
+	uint32_t		m_txQueueLimit;
+	double			m_txBitRate;
+
+	TracedCallback<Ptr<const Packet> > m_infectTrace;
+	TracedCallback<uint32_t, Ipv4Address> m_infectionTrace;	// (node id, infector address)
+	TracedCallback<Ipv4Address, uint32_t> m_elidedScanTrace;	// (target, bytes the train would have sent)
+
+private:
+	void ConnectionSucceeded (Ptr<Socket> socket);
+	void ConnectionFailed (Ptr<Socket> socket);
+	void StartScanning (void);
+	uint32_t GetScan (Ptr<Socket> socket) const;
+	void NewPeer (uint32_t scan);
+	void HandleReceive (Ptr<Socket> socket);
+	void Receive (Ptr<Packet> packet, Ipv4Address from);
+	uint32_t GetWireSize (void) const;
+	void udpDataSend (uint32_t scan, uint32_t remaining);
+	void ResolveTxDevice (Ipv4Address peer);
+	Ptr<NetDevice> GetRouteDevice (Ipv4Address peer) const;
+	uint32_t GetAccessLink (Ipv4Address peer) const;
+	bool CanSendEarly (Time departure) const;
+};
+
+class WormHelper
+{
+	public:
+	WormHelper (std::string protocol, Address address);
+
+	void SetAttribute (std::string name, const AttributeValue &value);
+
+	ApplicationContainer Install (NodeContainer c) const;
+
+	ApplicationContainer Install (Ptr<Node> node) const;
+
+	ApplicationContainer Install (std::string nodeName) const;
+
+	/**
+	 * Assign fixed random variable streams to every WormApplication
+	 * installed on the given nodes.
+	 *
+	 * \param c NodeContainer of the set of nodes to consider
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this helper
+	 */
+	int64_t AssignStreams (NodeContainer c, int64_t stream);
+
+	private:
+	Ptr<Application> InstallPriv (Ptr<Node> node) const;
+
+	ObjectFactory m_factory;
+};
+
+} // namespace ns3
+
+#endif /* WORM_H */
@@ -0,0 +1,126 @@
+#include "../common/address-plan.h"
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/point-to-point-helper.h"
+
+using namespace ns3;
+
+/**
+ * Point-to-point /30s come out in order, and every assigned address maps
+ * back to its node, also after the index has grown.
+ */
+class AddressPlanPointToPointTestCase : public TestCase
+{
+public:
+  AddressPlanPointToPointTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AddressPlanPointToPointTestCase::AddressPlanPointToPointTestCase ()
+  : TestCase ("AssignPointToPoint hands out consecutive /30s that LookupNode resolves")
+{
+}
+
+void
+AddressPlanPointToPointTestCase::DoRun (void)
+{
+  // past the index's initial 512 entries, so it grows at least once
+  const uint32_t links = 300;
+  NodeContainer nodes;
+  nodes.Create (2 * links);
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  PointToPointHelper p2p;
+
+  AddressPlan plan;
+  for (uint32_t i = 0; i < links; i++)
+    {
+      NetDeviceContainer devices = p2p.Install (nodes.Get (2 * i), nodes.Get (2 * i + 1));
+      Ipv4InterfaceContainer interfaces = plan.AssignPointToPoint (devices);
+      NS_TEST_ASSERT_MSG_EQ (interfaces.GetAddress (0), Ipv4Address (Ipv4Address ("10.0.0.0").Get () + 4 * i + 1),
+                             "link " << i << " first device");
+      NS_TEST_ASSERT_MSG_EQ (interfaces.GetAddress (1), Ipv4Address (Ipv4Address ("10.0.0.0").Get () + 4 * i + 2),
+                             "link " << i << " second device");
+    }
+  NS_TEST_ASSERT_MSG_EQ (plan.GetNAddresses (), 2 * links, "one address per device");
+
+  for (uint32_t i = 0; i < links; i++)
+    {
+      uint32_t network = Ipv4Address ("10.0.0.0").Get () + 4 * i;
+      NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (network + 1)), nodes.Get (2 * i)->GetId (),
+                             "link " << i << " first device");
+      NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (network + 2)), nodes.Get (2 * i + 1)->GetId (),
+                             "link " << i << " second device");
+      NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (network)), AddressPlan::NO_NODE,
+                             "network address of link " << i);
+      NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (network + 3)), AddressPlan::NO_NODE,
+                             "broadcast address of link " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (Ipv4Address ("10.0.0.0").Get () + 4 * links + 1)),
+                         AddressPlan::NO_NODE, "first address past the plan");
+  NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address ("0.0.0.0")), AddressPlan::NO_NODE, "any address");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Subnets are aligned to their size, and point-to-point links after them
+ * continue behind the subnet.
+ */
+class AddressPlanSubnetTestCase : public TestCase
+{
+public:
+  AddressPlanSubnetTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AddressPlanSubnetTestCase::AddressPlanSubnetTestCase ()
+  : TestCase ("AssignSubnet aligns its block and the pool continues behind it")
+{
+}
+
+void
+AddressPlanSubnetTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (6);
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  PointToPointHelper p2p;
+
+  AddressPlan plan;
+  Ipv4InterfaceContainer first = plan.AssignPointToPoint (p2p.Install (nodes.Get (0), nodes.Get (1)));
+  Ipv4InterfaceContainer subnet = plan.AssignSubnet (p2p.Install (nodes.Get (2), nodes.Get (3)), 16);
+  Ipv4InterfaceContainer last = plan.AssignPointToPoint (p2p.Install (nodes.Get (4), nodes.Get (5)));
+
+  NS_TEST_ASSERT_MSG_EQ (first.GetAddress (0), Ipv4Address ("10.0.0.1"), "first /30");
+  NS_TEST_ASSERT_MSG_EQ (subnet.GetAddress (0), Ipv4Address ("10.1.0.1"), "/16 after the first /30");
+  NS_TEST_ASSERT_MSG_EQ (subnet.GetAddress (1), Ipv4Address ("10.1.0.2"), "second host of the /16");
+  NS_TEST_ASSERT_MSG_EQ (last.GetAddress (0), Ipv4Address ("10.2.0.1"), "/30 after the /16");
+  NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address ("10.1.0.2")), nodes.Get (3)->GetId (), "subnet host");
+  NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address ("10.0.0.5")), AddressPlan::NO_NODE, "skipped by the alignment");
+
+  Simulator::Destroy ();
+}
+
+class AddressPlanTestSuite : public TestSuite
+{
+public:
+  AddressPlanTestSuite ();
+};
+
+AddressPlanTestSuite::AddressPlanTestSuite ()
+  : TestSuite ("address-plan", UNIT)
+{
+  AddTestCase (new AddressPlanPointToPointTestCase, TestCase::QUICK);
+  AddTestCase (new AddressPlanSubnetTestCase, TestCase::QUICK);
+}
+
+static AddressPlanTestSuite g_addressPlanTestSuite;
@@ -0,0 +1,112 @@
+#include "../p4/dumbbell-topology-helper.h"
+#include "../common/address-plan.h"
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+
+using namespace ns3;
+
+/**
+ * The AddressPlan assignment order that p4_barbell and p4.cc derive their
+ * scan space from: bottleneck, left leaf links, right leaf links, leaf on
+ * the first address.
+ */
+class DumbbellAddressPlanTestCase : public TestCase
+{
+public:
+  DumbbellAddressPlanTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DumbbellAddressPlanTestCase::DumbbellAddressPlanTestCase ()
+  : TestCase ("AssignIpv4Addresses (AddressPlan &) gives right leaf i block 1 + LeftCount () + i")
+{
+}
+
+void
+DumbbellAddressPlanTestCase::DoRun (void)
+{
+  PointToPointHelper link;
+  DumbbellTopologyHelper dumbbell (3, link, 2, link, link);
+  dumbbell.InstallStack (InternetStackHelper ());
+  AddressPlan plan;
+  dumbbell.AssignIpv4Addresses (plan);
+
+  uint32_t base = Ipv4Address ("10.0.0.0").Get ();
+  for (uint32_t i = 0; i < dumbbell.LeftCount (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dumbbell.GetLeftIpv4Address (i), Ipv4Address (base + 4 * (1 + i) + 1), "left leaf " << i);
+    }
+  for (uint32_t i = 0; i < dumbbell.RightCount (); i++)
+    {
+      Ipv4Address address (base + 4 * (1 + dumbbell.LeftCount () + i) + 1);
+      NS_TEST_ASSERT_MSG_EQ (dumbbell.GetRightIpv4Address (i), address, "right leaf " << i);
+      NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (address), dumbbell.GetRight (i)->GetId (), "right leaf " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (base + 1)), dumbbell.GetLeft ()->GetId (), "left router");
+  NS_TEST_ASSERT_MSG_EQ (plan.LookupNode (Ipv4Address (base + 2)), dumbbell.GetRight ()->GetId (), "right router");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Leaves split evenly over the systems, each router with its first leaf.
+ */
+class DumbbellSystemsTestCase : public TestCase
+{
+public:
+  DumbbellSystemsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DumbbellSystemsTestCase::DumbbellSystemsTestCase ()
+  : TestCase ("Leaves are split into equal blocks over all systems")
+{
+}
+
+void
+DumbbellSystemsTestCase::DoRun (void)
+{
+  PointToPointHelper link;
+  DumbbellTopologyHelper dumbbell (3, link, 3, link, link, 3);
+
+  const uint32_t left[] = { 0, 0, 1 };
+  const uint32_t right[] = { 1, 2, 2 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dumbbell.GetLeft (i)->GetSystemId (), left[i], "left leaf " << i);
+      NS_TEST_ASSERT_MSG_EQ (dumbbell.GetRight (i)->GetSystemId (), right[i], "right leaf " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (dumbbell.GetLeft ()->GetSystemId (), 0u, "left router");
+  NS_TEST_ASSERT_MSG_EQ (dumbbell.GetRight ()->GetSystemId (), 1u, "right router");
+
+  // two systems and equal sides: one side each, as before
+  DumbbellTopologyHelper halves (4, link, 4, link, link, 2);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (halves.GetLeft (i)->GetSystemId (), 0u, "left leaf " << i);
+      NS_TEST_ASSERT_MSG_EQ (halves.GetRight (i)->GetSystemId (), 1u, "right leaf " << i);
+    }
+
+  Simulator::Destroy ();
+}
+
+class DumbbellTopologyHelperTestSuite : public TestSuite
+{
+public:
+  DumbbellTopologyHelperTestSuite ();
+};
+
+DumbbellTopologyHelperTestSuite::DumbbellTopologyHelperTestSuite ()
+  : TestSuite ("dumbbell-topology-helper", UNIT)
+{
+  AddTestCase (new DumbbellAddressPlanTestCase, TestCase::QUICK);
+  AddTestCase (new DumbbellSystemsTestCase, TestCase::QUICK);
+}
+
+static DumbbellTopologyHelperTestSuite g_dumbbellTopologyHelperTestSuite;
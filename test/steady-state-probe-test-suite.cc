@@ -0,0 +1,72 @@
+#include "../common/steady-state-probe.h"
+
+#include <vector>
+
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * MSER deletes exactly the warm-up of a ramp followed by a level series,
+ * with and without noise on the level, and nothing from a level series.
+ */
+class MserTruncationTestCase : public TestCase
+{
+public:
+  MserTruncationTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MserTruncationTestCase::MserTruncationTestCase ()
+  : TestCase ("Truncate cuts a ramp-plus-constant series where the ramp ends")
+{
+}
+
+void
+MserTruncationTestCase::DoRun (void)
+{
+  std::vector<double> ramp;
+  for (uint32_t j = 0; j < 10; j++)
+    {
+      ramp.push_back (10.0 * j);
+    }
+
+  std::vector<double> level (ramp);
+  std::vector<double> noisy (ramp);
+  for (uint32_t j = 0; j < 30; j++)
+    {
+      level.push_back (100);
+      noisy.push_back (j % 2 ? 101 : 99);
+    }
+  NS_TEST_ASSERT_MSG_EQ (SteadyStateProbe::Truncate (level), 10u, "ramp of 10 then a constant");
+  NS_TEST_ASSERT_MSG_EQ (SteadyStateProbe::Truncate (noisy), 10u, "ramp of 10 then a noisy constant");
+
+  // the truncation never deletes more than half the batches
+  std::vector<double> longRamp;
+  for (uint32_t j = 0; j < 30; j++)
+    {
+      longRamp.push_back (10.0 * j);
+    }
+  longRamp.resize (40, 300);
+  NS_TEST_ASSERT_MSG_EQ (SteadyStateProbe::Truncate (longRamp), 20u, "ramp longer than half the series");
+
+  NS_TEST_ASSERT_MSG_EQ (SteadyStateProbe::Truncate (std::vector<double> (40, 100)), 0u, "constant series");
+  NS_TEST_ASSERT_MSG_EQ (SteadyStateProbe::Truncate (std::vector<double> (1, 100)), 0u, "single batch");
+  NS_TEST_ASSERT_MSG_EQ (SteadyStateProbe::Truncate (std::vector<double> ()), 0u, "no batches");
+}
+
+class SteadyStateProbeTestSuite : public TestSuite
+{
+public:
+  SteadyStateProbeTestSuite ();
+};
+
+SteadyStateProbeTestSuite::SteadyStateProbeTestSuite ()
+  : TestSuite ("steady-state-probe", UNIT)
+{
+  AddTestCase (new MserTruncationTestCase, TestCase::QUICK);
+}
+
+static SteadyStateProbeTestSuite g_steadyStateProbeTestSuite;
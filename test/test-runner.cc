@@ -0,0 +1,10 @@
+// Runs the TestSuites linked into it (see the Makefile); the options are
+// ns-3's test-runner's, e.g. --suite=address-plan --verbose.
+
+#include "ns3/test.h"
+
+int
+main (int argc, char *argv[])
+{
+  return ns3::TestRunner::Run (argc, argv);
+}
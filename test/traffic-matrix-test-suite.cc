@@ -0,0 +1,120 @@
+#include "../p3/traffic-matrix.h"
+
+#include <sstream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/vector.h"
+#include "ns3/mobility-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/random-variable-stream.h"
+
+using namespace ns3;
+
+/**
+ * The grid search of NearestNeighbour gives the same destination as a
+ * brute force search over every other node, lower index on ties, for
+ * uniform positions of several sizes and for a regular lattice, where
+ * every node has tied neighbours across cell borders.
+ */
+class NearestNeighbourTestCase : public TestCase
+{
+public:
+  NearestNeighbourTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Check (NodeContainer nodes, std::string layout);
+};
+
+NearestNeighbourTestCase::NearestNeighbourTestCase ()
+  : TestCase ("TrafficMatrix::NearestNeighbour matches a brute force search")
+{
+}
+
+void
+NearestNeighbourTestCase::Check (NodeContainer nodes, std::string layout)
+{
+  uint32_t n = nodes.GetN ();
+  std::vector<Vector> position (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      position[i] = nodes.Get (i)->GetObject<MobilityModel> ()->GetPosition ();
+    }
+
+  Ptr<TrafficMatrix> matrix = CreateObject<TrafficMatrix> ();
+  matrix->NearestNeighbour (nodes);
+  const std::vector<TrafficMatrix::Flow> &flows = matrix->GetFlows ();
+  NS_TEST_ASSERT_MSG_EQ (flows.size (), n, layout << ": one flow per node");
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t best = i;
+      double bestDistance = 0;
+      for (uint32_t j = 0; j < n; j++)
+        {
+          double dx = position[i].x - position[j].x;
+          double dy = position[i].y - position[j].y;
+          double dz = position[i].z - position[j].z;
+          double distance = dx * dx + dy * dy + dz * dz;
+          if (j != i && (best == i || distance < bestDistance))
+            {
+              best = j;
+              bestDistance = distance;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (flows[i].first, i, layout << ": source of flow " << i);
+      NS_TEST_ASSERT_MSG_EQ (flows[i].second, best, layout << ": nearest neighbour of node " << i);
+    }
+}
+
+void
+NearestNeighbourTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  const uint32_t sizes[] = { 2, 3, 10, 100, 1000 };
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+      NodeContainer nodes;
+      nodes.Create (sizes[s]);
+      for (uint32_t i = 0; i < nodes.GetN (); i++)
+        {
+          Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (Vector (rng->GetValue (0, 1000), rng->GetValue (0, 1000), 0));
+          nodes.Get (i)->AggregateObject (mobility);
+        }
+      std::ostringstream layout;
+      layout << sizes[s] << " uniform nodes";
+      Check (nodes, layout.str ());
+    }
+
+  NodeContainer lattice;
+  lattice.Create (400);
+  for (uint32_t i = 0; i < lattice.GetN (); i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (10.0 * (i % 20), 10.0 * (i / 20), 0));
+      lattice.Get (i)->AggregateObject (mobility);
+    }
+  Check (lattice, "20 x 20 lattice");
+
+  Simulator::Destroy ();
+}
+
+class TrafficMatrixTestSuite : public TestSuite
+{
+public:
+  TrafficMatrixTestSuite ();
+};
+
+TrafficMatrixTestSuite::TrafficMatrixTestSuite ()
+  : TestSuite ("traffic-matrix", UNIT)
+{
+  AddTestCase (new NearestNeighbourTestCase, TestCase::QUICK);
+}
+
+static TrafficMatrixTestSuite g_trafficMatrixTestSuite;
@@ -0,0 +1,165 @@
+#include "../p4/worm-scan-strategy.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable-stream.h"
+
+using namespace ns3;
+
+namespace {
+
+Ptr<UniformRandomVariable>
+ScanStream (int64_t stream)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (stream);
+  return rng;
+}
+
+} // anonymous namespace
+
+/**
+ * Every cycle of range draws visits each index exactly once, for ranges
+ * that are and are not a power of four (the Feistel domain).
+ */
+class PermutationScanTestCase : public TestCase
+{
+public:
+  PermutationScanTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PermutationScanTestCase::PermutationScanTestCase ()
+  : TestCase ("PermutationScanStrategy visits each index exactly once per cycle")
+{
+}
+
+void
+PermutationScanTestCase::DoRun (void)
+{
+  const uint32_t ranges[] = { 1, 2, 3, 4, 5, 7, 16, 17, 255, 256, 1000, 4096, 4097, 65537 };
+  for (uint32_t r = 0; r < sizeof (ranges) / sizeof (ranges[0]); r++)
+    {
+      uint32_t range = ranges[r];
+      Ptr<PermutationScanStrategy> strategy = CreateObject<PermutationScanStrategy> ();
+      strategy->Setup (range, range, ScanStream (r));
+      for (uint32_t cycle = 0; cycle < 2; cycle++)
+        {
+          std::vector<bool> seen (range, false);
+          for (uint32_t i = 0; i < range; i++)
+            {
+              uint32_t index = strategy->Next ();
+              NS_TEST_ASSERT_MSG_LT (index, range, "range " << range << " draw " << i);
+              NS_TEST_ASSERT_MSG_EQ (bool (seen[index]), false, "range " << range << " index " << index << " twice");
+              seen[index] = true;
+            }
+        }
+    }
+}
+
+/**
+ * With a fixed Key every worm walks the same cycle, from its own start.
+ */
+class PermutationKeyTestCase : public TestCase
+{
+public:
+  PermutationKeyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PermutationKeyTestCase::PermutationKeyTestCase ()
+  : TestCase ("PermutationScanStrategy with a shared Key gives rotations of one cycle")
+{
+}
+
+void
+PermutationKeyTestCase::DoRun (void)
+{
+  const uint32_t range = 1000;
+  std::vector<uint32_t> cycles[2];
+  for (uint32_t w = 0; w < 2; w++)
+    {
+      Ptr<PermutationScanStrategy> strategy = CreateObject<PermutationScanStrategy> ();
+      strategy->SetAttribute ("Key", UintegerValue (7));
+      strategy->Setup (range, range, ScanStream (w));
+      for (uint32_t i = 0; i < range; i++)
+        {
+          cycles[w].push_back (strategy->Next ());
+        }
+    }
+  std::vector<uint32_t>::iterator start = std::find (cycles[1].begin (), cycles[1].end (), cycles[0][0]);
+  NS_TEST_ASSERT_MSG_EQ ((start != cycles[1].end ()), true, "first target of worm 0 in the cycle of worm 1");
+  std::rotate (cycles[1].begin (), start, cycles[1].end ());
+  NS_TEST_ASSERT_MSG_EQ ((cycles[0] == cycles[1]), true, "the cycles are rotations of each other");
+}
+
+/**
+ * The hit list is walked once, every entry exactly once, before the
+ * uniform fallback, and is clipped to the range.
+ */
+class HitListScanTestCase : public TestCase
+{
+public:
+  HitListScanTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+HitListScanTestCase::HitListScanTestCase ()
+  : TestCase ("HitListScanStrategy covers its list once before scanning uniformly")
+{
+}
+
+void
+HitListScanTestCase::DoRun (void)
+{
+  const uint32_t range = 256;
+  // inside the range, and clipped at its end
+  const uint32_t offsets[] = { 10, 250 };
+  const uint32_t sizes[] = { 20, 6 };
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      Ptr<HitListScanStrategy> strategy = CreateObject<HitListScanStrategy> ();
+      strategy->SetAttribute ("Offset", UintegerValue (offsets[c]));
+      strategy->SetAttribute ("Size", UintegerValue (20));
+      strategy->Setup (range, range, ScanStream (c));
+      std::vector<bool> seen (range, false);
+      for (uint32_t i = 0; i < sizes[c]; i++)
+        {
+          uint32_t index = strategy->Next ();
+          NS_TEST_ASSERT_MSG_EQ ((index >= offsets[c] && index < offsets[c] + sizes[c]), true,
+                                 "hit list entry " << i << " is " << index);
+          NS_TEST_ASSERT_MSG_EQ (bool (seen[index]), false, "index " << index << " twice");
+          seen[index] = true;
+        }
+      for (uint32_t i = 0; i < 1000; i++)
+        {
+          uint32_t index = strategy->Next ();
+          NS_TEST_ASSERT_MSG_LT (index, range, "uniform draw " << i);
+        }
+    }
+}
+
+class WormScanStrategyTestSuite : public TestSuite
+{
+public:
+  WormScanStrategyTestSuite ();
+};
+
+WormScanStrategyTestSuite::WormScanStrategyTestSuite ()
+  : TestSuite ("worm-scan-strategy", UNIT)
+{
+  AddTestCase (new PermutationScanTestCase, TestCase::QUICK);
+  AddTestCase (new PermutationKeyTestCase, TestCase::QUICK);
+  AddTestCase (new HitListScanTestCase, TestCase::QUICK);
+}
+
+static WormScanStrategyTestSuite g_wormScanStrategyTestSuite;
@@ -0,0 +1,412 @@
+#include "../p4/worm.h"
+#include "../common/address-plan.h"
+
+#include <set>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/point-to-point-helper.h"
+
+using namespace ns3;
+
+namespace {
+
+const uint16_t WORM_PORT = 1000;
+
+/**
+ * Two spokes on a hub, spoke i on 10.0.0.(4i + 1), so a worm scanning
+ * ScanNetwork 10.0.0.0 with ScanStride 4, ScanHost 1 and ScanRange 2
+ * reaches exactly the two spokes, itself included.
+ */
+class WormStar
+{
+public:
+  WormStar ();
+
+  Ptr<Node> GetSpoke (uint32_t i) const;
+  Ipv4Address GetSpokeAddress (uint32_t i) const;
+  WormHelper GetWorm (uint32_t i) const;
+  const AddressPlan *GetPlan (void) const;
+
+private:
+  AddressPlan m_plan;
+  NodeContainer m_hub;
+  NodeContainer m_spokes;
+  Ipv4InterfaceContainer m_spokeInterfaces;
+};
+
+WormStar::WormStar ()
+{
+  m_hub.Create (1);
+  m_spokes.Create (2);
+  InternetStackHelper stack;
+  stack.Install (m_hub);
+  stack.Install (m_spokes);
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  for (uint32_t i = 0; i < m_spokes.GetN (); i++)
+    {
+      m_spokeInterfaces.Add (m_plan.AssignPointToPoint (link.Install (m_spokes.Get (i), m_hub.Get (0))).Get (0));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+}
+
+Ptr<Node>
+WormStar::GetSpoke (uint32_t i) const
+{
+  return m_spokes.Get (i);
+}
+
+Ipv4Address
+WormStar::GetSpokeAddress (uint32_t i) const
+{
+  return m_spokeInterfaces.GetAddress (i);
+}
+
+const AddressPlan *
+WormStar::GetPlan (void) const
+{
+  return &m_plan;
+}
+
+WormHelper
+WormStar::GetWorm (uint32_t i) const
+{
+  WormHelper worm ("ns3::UdpSocketFactory", InetSocketAddress (GetSpokeAddress (i), WORM_PORT));
+  worm.SetAttribute ("ScanNetwork", Ipv4AddressValue ("10.0.0.0"));
+  worm.SetAttribute ("ScanStride", UintegerValue (4));
+  worm.SetAttribute ("ScanHost", UintegerValue (1));
+  worm.SetAttribute ("ScanRange", UintegerValue (2));
+  worm.SetAttribute ("Payload", UintegerValue (4));
+  worm.SetAttribute ("Interval", DoubleValue (0.5));
+  worm.SetAttribute ("PrintInfections", BooleanValue (false));
+  return worm;
+}
+
+/**
+ * A UDP socket on the worm port that counts what arrives, when, and from
+ * which source ports.
+ */
+class WormSink
+{
+public:
+  WormSink (Ptr<Node> node);
+
+  uint32_t packets;
+  std::set<uint16_t> ports;
+  std::vector<Time> arrivals;
+
+private:
+  void HandleRead (Ptr<Socket> socket);
+};
+
+WormSink::WormSink (Ptr<Node> node)
+  : packets (0)
+{
+  Ptr<Socket> socket = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+  socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), WORM_PORT));
+  socket->SetRecvCallback (MakeCallback (&WormSink::HandleRead, this));
+}
+
+void
+WormSink::HandleRead (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      packets++;
+      arrivals.push_back (Simulator::Now ());
+      ports.insert (InetSocketAddress::ConvertFrom (from).GetPort ());
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * A clean worm is infected by the worm packet after InfectThreshold, not
+ * before, and reports its infector.
+ */
+class WormInfectThresholdTestCase : public TestCase
+{
+public:
+  WormInfectThresholdTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Check (uint32_t i);
+  void Infected (uint32_t node, Ipv4Address infector);
+
+  Ptr<WormApplication> m_worm;
+  bool m_infected[2];
+  Ipv4Address m_infector;
+};
+
+WormInfectThresholdTestCase::WormInfectThresholdTestCase ()
+  : TestCase ("WormApplication is infected by the packet after InfectThreshold")
+{
+}
+
+void
+WormInfectThresholdTestCase::Check (uint32_t i)
+{
+  m_infected[i] = m_worm->isInfected ();
+}
+
+void
+WormInfectThresholdTestCase::Infected (uint32_t node, Ipv4Address infector)
+{
+  m_infector = infector;
+}
+
+void
+WormInfectThresholdTestCase::DoRun (void)
+{
+  m_infected[0] = m_infected[1] = false;
+  WormStar star;
+  WormHelper seed = star.GetWorm (0);
+  seed.SetAttribute ("Infected", BooleanValue (true));
+  seed.Install (star.GetSpoke (0));
+  WormHelper clean = star.GetWorm (1);
+  clean.SetAttribute ("InfectThreshold", UintegerValue (4));
+  m_worm = DynamicCast<WormApplication> (clean.Install (star.GetSpoke (1)).Get (0));
+  m_worm->TraceConnectWithoutContext ("Infection", MakeCallback (&WormInfectThresholdTestCase::Infected, this));
+
+  // the first train of four packets has arrived by 0.45 s, the fifth
+  // packet leaves at 0.5 s
+  Simulator::Schedule (Seconds (0.45), &WormInfectThresholdTestCase::Check, this, 0);
+  Simulator::Schedule (Seconds (0.6), &WormInfectThresholdTestCase::Check, this, 1);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_infected[0], false, "infected by InfectThreshold packets");
+  NS_TEST_ASSERT_MSG_EQ (m_infected[1], true, "not infected by InfectThreshold + 1 packets");
+  NS_TEST_ASSERT_MSG_EQ (m_infector, star.GetSpokeAddress (0), "infector address");
+
+  m_worm = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * NewPeer never picks the worm's own address: in a scan space of itself
+ * and one other spoke every train reaches the other spoke.
+ */
+class WormSelfSkipTestCase : public TestCase
+{
+public:
+  WormSelfSkipTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WormSelfSkipTestCase::WormSelfSkipTestCase ()
+  : TestCase ("WormApplication never scans its own address")
+{
+}
+
+void
+WormSelfSkipTestCase::DoRun (void)
+{
+  WormStar star;
+  WormSink sink (star.GetSpoke (1));
+  WormHelper seed = star.GetWorm (0);
+  seed.SetAttribute ("Infected", BooleanValue (true));
+  ApplicationContainer apps = seed.Install (star.GetSpoke (0));
+  apps.Stop (Seconds (9.9));
+  Simulator::Stop (Seconds (11));
+  Simulator::Run ();
+
+  // 4 packets every 0.5 s, the last at 9.875 s
+  NS_TEST_ASSERT_MSG_EQ (sink.packets, 80u, "trains to the other spoke");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * The same scan stream gives the same targets; another stream does not.
+ */
+class WormAssignStreamsTestCase : public TestCase
+{
+public:
+  WormAssignStreamsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  std::vector<Ipv4Address> Scan (int64_t stream);
+  void Elided (Ipv4Address target, uint32_t bytes);
+
+  std::vector<Ipv4Address> m_targets;
+};
+
+WormAssignStreamsTestCase::WormAssignStreamsTestCase ()
+  : TestCase ("WormApplication::AssignStreams makes the scan targets reproducible")
+{
+}
+
+void
+WormAssignStreamsTestCase::Elided (Ipv4Address target, uint32_t bytes)
+{
+  m_targets.push_back (target);
+}
+
+std::vector<Ipv4Address>
+WormAssignStreamsTestCase::Scan (int64_t stream)
+{
+  // every target of 10.1.0.0/16 misses the plan, so every scan is elided
+  // and reported without traffic
+  WormStar star;
+  WormHelper seed = star.GetWorm (0);
+  seed.SetAttribute ("Infected", BooleanValue (true));
+  seed.SetAttribute ("ScanNetwork", Ipv4AddressValue ("10.1.0.0"));
+  seed.SetAttribute ("ScanRange", UintegerValue (1000));
+  seed.SetAttribute ("ElideMisses", BooleanValue (true));
+  Ptr<WormApplication> worm = DynamicCast<WormApplication> (seed.Install (star.GetSpoke (0)).Get (0));
+  worm->SetTargetIndex (star.GetPlan ());
+  worm->TraceConnectWithoutContext ("ElidedScan", MakeCallback (&WormAssignStreamsTestCase::Elided, this));
+  worm->AssignStreams (stream);
+
+  m_targets.clear ();
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_targets;
+}
+
+void
+WormAssignStreamsTestCase::DoRun (void)
+{
+  std::vector<Ipv4Address> first = Scan (7);
+  std::vector<Ipv4Address> again = Scan (7);
+  std::vector<Ipv4Address> other = Scan (8);
+
+  NS_TEST_ASSERT_MSG_EQ (first.size (), 20u, "one elided scan per Interval");
+  NS_TEST_ASSERT_MSG_EQ ((first == again), true, "same stream, same targets");
+  NS_TEST_ASSERT_MSG_EQ ((first == other), false, "another stream, other targets");
+}
+
+/**
+ * ConnectCount scans send from ConnectCount sockets, created once and
+ * reused for every target: the receive socket and ConnectCount - 1
+ * ephemeral ports.
+ */
+class WormConnectCountTestCase : public TestCase
+{
+public:
+  WormConnectCountTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WormConnectCountTestCase::WormConnectCountTestCase ()
+  : TestCase ("WormApplication reuses one sender socket per concurrent scan")
+{
+}
+
+void
+WormConnectCountTestCase::DoRun (void)
+{
+  WormStar star;
+  WormSink sink (star.GetSpoke (1));
+  WormHelper seed = star.GetWorm (0);
+  seed.SetAttribute ("Infected", BooleanValue (true));
+  seed.SetAttribute ("ConnectCount", UintegerValue (3));
+  ApplicationContainer apps = seed.Install (star.GetSpoke (0));
+  apps.Stop (Seconds (9.9));
+  Simulator::Stop (Seconds (11));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (sink.packets, 240u, "three scans of 4 packets every 0.5 s");
+  NS_TEST_ASSERT_MSG_EQ (sink.ports.size (), 3u, "one source port per scan");
+  NS_TEST_ASSERT_MSG_EQ ((sink.ports.count (WORM_PORT) == 1), true, "the first scan sends from the receive socket");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * An elided scan with a route keeps the access link busy for its train's
+ * serialization time: a real train of a concurrent scan waits for it.
+ */
+class WormElideChargeTestCase : public TestCase
+{
+public:
+  WormElideChargeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WormElideChargeTestCase::WormElideChargeTestCase ()
+  : TestCase ("WormApplication charges elided trains to the access link")
+{
+}
+
+void
+WormElideChargeTestCase::DoRun (void)
+{
+  // the third slot, 10.0.0.9, is in no plan; a default route on the
+  // seed sends it towards the hub, so a real train would leave by the
+  // spoke's only link
+  WormStar star;
+  Ipv4StaticRoutingHelper staticRouting;
+  staticRouting.GetStaticRouting (star.GetSpoke (0)->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("10.0.0.2"), 1);
+  WormSink sink (star.GetSpoke (1));
+  WormHelper seed = star.GetWorm (0);
+  seed.SetAttribute ("Infected", BooleanValue (true));
+  seed.SetAttribute ("ScanRange", UintegerValue (3));
+  seed.SetAttribute ("ScanStrategy", StringValue ("ns3::SequentialScanStrategy"));
+  seed.SetAttribute ("ConnectCount", UintegerValue (2));
+  seed.SetAttribute ("SendSize", UintegerValue (1000));
+  seed.SetAttribute ("Interval", DoubleValue (0.01));
+  seed.SetAttribute ("ElideMisses", BooleanValue (true));
+  Ptr<WormApplication> worm = DynamicCast<WormApplication> (seed.Install (star.GetSpoke (0)).Get (0));
+  worm->SetTargetIndex (star.GetPlan ());
+  Simulator::Stop (Seconds (0.05));
+  Simulator::Run ();
+
+  // At 0 s one scan hits the other spoke and one misses.  The missed train
+  // is 4 x 1030 bytes, 6.592 ms at 5 Mbps, so no hit packet but the one
+  // sent at 0 s leaves before then; two 1.648 ms hops of 1 ms each put the
+  // second arrival at 11.888 ms, against 7.796 ms for an uncharged link.
+  NS_TEST_ASSERT_MSG_EQ (worm->GetElidedScans () > 0, true, "the miss is elided");
+  NS_TEST_ASSERT_MSG_EQ (sink.arrivals.size () >= 2, true, "the hits arrive");
+  NS_TEST_ASSERT_MSG_EQ ((sink.arrivals[1] > Seconds (0.01)), true, "the second hit packet waits for the elided train");
+
+  Simulator::Destroy ();
+}
+
+class WormTestSuite : public TestSuite
+{
+public:
+  WormTestSuite ();
+};
+
+WormTestSuite::WormTestSuite ()
+  : TestSuite ("worm", UNIT)
+{
+  AddTestCase (new WormInfectThresholdTestCase, TestCase::QUICK);
+  AddTestCase (new WormSelfSkipTestCase, TestCase::QUICK);
+  AddTestCase (new WormAssignStreamsTestCase, TestCase::QUICK);
+  AddTestCase (new WormConnectCountTestCase, TestCase::QUICK);
+  AddTestCase (new WormElideChargeTestCase, TestCase::QUICK);
+}
+
+static WormTestSuite g_wormTestSuite;